@@ -14,6 +14,7 @@
 #include "read_pipeline/ResumeLoaderNode.h"
 #include "utils/bam_utils.h"
 #include "utils/basecaller_utils.h"
+#include "utils/chunk_cache.h"
 #include "utils/cli_utils.h"
 #include "utils/log_utils.h"
 #include "utils/models.h"
@@ -60,9 +61,12 @@ void setup(std::vector<std::string> args,
            int window_size,
            uint64_t mm2_index_batch_size,
            bool skip_model_compatibility_check,
+           bool viterbi,
+           size_t num_cpu_decode_threads,
            const std::string& dump_stats_file,
            const std::string& dump_stats_filter,
            const std::string& resume_from_file,
+           const std::string& chunk_cache_dir,
            argparse::ArgumentParser& resume_parser) {
     torch::set_num_threads(1);
 
@@ -95,8 +99,11 @@ void setup(std::vector<std::string> args,
     }
 
     auto model_config = dorado::load_crf_model_config(model_path);
+    const auto decode_strategy = viterbi ? DecodeStrategy::Viterbi : DecodeStrategy::BeamSearch;
     auto [runners, num_devices] =
-            create_basecall_runners(model_config, device, num_runners, batch_size, chunk_size);
+            create_basecall_runners(model_config, device, num_runners, batch_size, chunk_size, 1.f,
+                                    false, decode_strategy,
+                                    create_cpu_decoder(device, num_cpu_decode_threads));
 
     std::string model_name = std::filesystem::canonical(model_path).filename().string();
     auto read_groups = DataLoader::load_read_groups(data_path, model_name, recursive_file_loading);
@@ -136,10 +143,16 @@ void setup(std::vector<std::string> args,
             {read_converter}, min_qscore, default_parameters.min_sequence_length,
             std::unordered_set<std::string>{}, thread_allocations.read_filter_threads);
 
+    std::shared_ptr<const utils::ChunkCache> chunk_cache;
+    if (!chunk_cache_dir.empty()) {
+        chunk_cache = std::make_shared<utils::ChunkCache>(
+                chunk_cache_dir, device, viterbi ? "viterbi" : "beam_search", model_path);
+    }
+
     pipelines::create_simplex_pipeline(
             pipeline_desc, model_config, std::move(runners), std::move(remora_runners), overlap,
             thread_allocations.scaler_node_threads, thread_allocations.remora_threads * num_devices,
-            read_filter_node);
+            read_filter_node, PipelineDescriptor::InvalidNodeHandle, std::move(chunk_cache));
 
     // Create the Pipeline from our description.
     std::vector<dorado::stats::StatsReporter> stats_reporters;
@@ -244,6 +257,11 @@ int basecaller(int argc, char* argv[]) {
                   "processed again.")
             .default_value(std::string(""));
 
+    parser.add_argument("--chunk-cache")
+            .help("Directory in which to cache decoded chunks, so that chunks seen by an earlier "
+                  "run with the same model and type of device are not basecalled again.")
+            .default_value(std::string(""));
+
     parser.add_argument("-n", "--max-reads").default_value(0).scan<'i', int>();
 
     parser.add_argument("--min-qscore").default_value(0).scan<'i', int>();
@@ -394,9 +412,12 @@ int basecaller(int argc, char* argv[]) {
               parser.get<bool>("--recursive"), parser.get<int>("k"), parser.get<int>("w"),
               utils::parse_string_to_size(parser.get<std::string>("I")),
               internal_parser.get<bool>("--skip-model-compatibility-check"),
+              internal_parser.get<bool>("--viterbi"),
+              internal_parser.get<int>("--cpu-decode-threads"),
               internal_parser.get<std::string>("--dump_stats_file"),
               internal_parser.get<std::string>("--dump_stats_filter"),
-              parser.get<std::string>("--resume-from"), resume_parser);
+              parser.get<std::string>("--resume-from"), parser.get<std::string>("--chunk-cache"),
+              resume_parser);
     } catch (const std::exception& e) {
         spdlog::error("{}", e.what());
         return 1;
@@ -5,5 +5,6 @@ int duplex(int argc, char *argv[]);
 int download(int argc, char *argv[]);
 int aligner(int argc, char *argv[]);
 int summary(int argc, char *argv[]);
+int pack(int argc, char *argv[]);
 
 }  // namespace dorado
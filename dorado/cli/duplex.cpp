@@ -5,12 +5,14 @@
 #include "read_pipeline/AlignerNode.h"
 #include "read_pipeline/BaseSpaceDuplexCallerNode.h"
 #include "read_pipeline/DuplexReadTaggingNode.h"
+#include "read_pipeline/HtsReader.h"
 #include "read_pipeline/HtsWriter.h"
 #include "read_pipeline/Pipelines.h"
 #include "read_pipeline/ProgressTracker.h"
 #include "read_pipeline/ReadFilterNode.h"
 #include "read_pipeline/ReadToBamTypeNode.h"
 #include "utils/bam_utils.h"
+#include "utils/chunk_cache.h"
 #include "utils/cli_utils.h"
 #include "utils/duplex_utils.h"
 #include "utils/log_utils.h"
@@ -102,6 +104,12 @@ int duplex(int argc, char* argv[]) {
 
     parser.add_argument("-I").help("minimap2 index batch size.").default_value(std::string("16G"));
 
+    parser.add_argument("--chunk-cache")
+            .help("Directory in which to cache decoded simplex and stereo chunks, so that chunks "
+                  "seen by an earlier run with the same models and type of device are not "
+                  "basecalled again.")
+            .default_value(std::string(""));
+
     parser.add_argument("--guard-gpus")
             .default_value(false)
             .implicit_value(true)
@@ -217,14 +225,11 @@ int duplex(int argc, char* argv[]) {
                 return 1;  // Exit with an error code
             }
 
-            spdlog::info("> Loading reads");
-            auto read_map = read_bam(reads, read_list_from_pairs);
-
             spdlog::info("> Starting Basespace Duplex Pipeline");
             threads = threads == 0 ? std::thread::hardware_concurrency() : threads;
 
             auto duplex_caller_node = pipeline_desc.add_node<BaseSpaceDuplexCallerNode>(
-                    {read_filter_node}, template_complement_map, read_map, threads);
+                    {read_filter_node}, template_complement_map, threads);
 
             std::vector<dorado::stats::StatsReporter> stats_reporters;
             pipeline = Pipeline::create(std::move(pipeline_desc), &stats_reporters);
@@ -240,6 +245,11 @@ int duplex(int argc, char* argv[]) {
             constexpr auto kStatsPeriod = 100ms;
             stats_sampler = std::make_unique<dorado::stats::StatsSampler>(
                     kStatsPeriod, stats_reporters, stats_callables);
+
+            // Reads are streamed to the duplex caller, which calls each pair as soon as both of
+            // its reads have been seen, so the BAM is never held in memory.
+            HtsReader hts_reader(reads);
+            hts_reader.read(*pipeline);
         } else {  // Execute a Stereo Duplex pipeline.
 
             const auto model_path = std::filesystem::canonical(std::filesystem::path(model));
@@ -296,8 +306,12 @@ int duplex(int argc, char* argv[]) {
             // Note: The memory assignment between simplex and duplex callers have been
             // performed based on empirical results considering a SUP model for simplex
             // calling.
+            // The simplex and stereo runners share one decode pool on the CPU.
+            const auto cpu_decoder = create_cpu_decoder(
+                    device, internal_parser.get<int>("--cpu-decode-threads"));
             auto [runners, num_devices] = create_basecall_runners(
-                    model_config, device, num_runners, batch_size, chunk_size, 0.9f, true);
+                    model_config, device, num_runners, batch_size, chunk_size, 0.9f, true,
+                    DecodeStrategy::BeamSearch, cpu_decoder);
 
             std::vector<Runner> stereo_runners;
             // The fraction argument for GPU memory allocates the fraction of the
@@ -309,9 +323,9 @@ int duplex(int argc, char* argv[]) {
             // memory footprint for both model and decode function. This will increase the
             // chances for the stereo model to use the cached allocations from the simplex
             // model.
-            std::tie(stereo_runners, std::ignore) =
-                    create_basecall_runners(stereo_model_config, device, num_runners,
-                                            stereo_batch_size, chunk_size, 0.5f, true);
+            std::tie(stereo_runners, std::ignore) = create_basecall_runners(
+                    stereo_model_config, device, num_runners, stereo_batch_size, chunk_size, 0.5f,
+                    true, DecodeStrategy::BeamSearch, cpu_decoder);
 
             spdlog::info("> Starting Stereo Duplex pipeline");
 
@@ -322,10 +336,22 @@ int duplex(int argc, char* argv[]) {
                 pairing_parameters = std::move(template_complement_map);
             }
 
+            // The simplex and stereo models share the cache directory, but not entries.
+            std::shared_ptr<const utils::ChunkCache> chunk_cache, stereo_chunk_cache;
+            const auto chunk_cache_dir = parser.get<std::string>("--chunk-cache");
+            if (!chunk_cache_dir.empty()) {
+                chunk_cache = std::make_shared<utils::ChunkCache>(
+                        chunk_cache_dir, device, "beam_search", model_config.model_path);
+                stereo_chunk_cache = std::make_shared<utils::ChunkCache>(
+                        chunk_cache_dir, device, "beam_search", stereo_model_config.model_path);
+            }
+
             pipelines::create_stereo_duplex_pipeline(
                     pipeline_desc, model_config, stereo_model_config, std::move(runners),
                     std::move(stereo_runners), overlap, num_devices * 2, num_devices,
-                    std::move(pairing_parameters), read_filter_node);
+                    std::move(pairing_parameters), read_filter_node,
+                    PipelineDescriptor::InvalidNodeHandle, std::move(chunk_cache),
+                    std::move(stereo_chunk_cache));
 
             std::vector<dorado::stats::StatsReporter> stats_reporters;
             pipeline = Pipeline::create(std::move(pipeline_desc), &stats_reporters);
@@ -0,0 +1,59 @@
+#include "Version.h"
+#include "utils/log_utils.h"
+#include "utils/tensor_utils.h"
+
+#include <argparse.hpp>
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace dorado {
+
+int pack(int argc, char* argv[]) {
+    utils::InitLogging();
+
+    argparse::ArgumentParser parser("dorado", DORADO_VERSION, argparse::default_arguments::help);
+    parser.add_argument("model").help(
+            "model directory whose .tensor files are packed into a single memory-mappable file.");
+    parser.add_argument("-v", "--verbose").default_value(false).implicit_value(true);
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::ostringstream parser_stream;
+        parser_stream << parser;
+        spdlog::error("{}\n{}", e.what(), parser_stream.str());
+        std::exit(1);
+    }
+
+    if (parser.get<bool>("--verbose")) {
+        utils::SetDebugLogging();
+    }
+
+    const auto model_dir = fs::path(parser.get<std::string>("model"));
+    if (!fs::is_directory(model_dir)) {
+        spdlog::error("{} is not a model directory", model_dir.string());
+        return 1;
+    }
+
+    try {
+        const auto num_tensors = utils::pack_tensors(model_dir);
+        if (num_tensors == 0) {
+            spdlog::error("No .tensor files found in {}", model_dir.string());
+            fs::remove(model_dir / utils::kPackedTensorsFilename);
+            return 1;
+        }
+        spdlog::info("> packed {} tensors into {}", num_tensors,
+                     (model_dir / utils::kPackedTensorsFilename).string());
+    } catch (const std::exception& e) {
+        spdlog::error("Failed to pack {}: {}", model_dir.string(), e.what());
+        return 1;
+    }
+
+    return 0;
+}
+
+}  // namespace dorado
@@ -4,14 +4,43 @@
 
 #include <torch/torch.h>
 
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace cxxpool {
+class thread_pool;
+}
+
 namespace dorado {
 
 class CPUDecoder final : Decoder {
 public:
+    // Chunks are decoded as individual tasks on a persistent pool of `num_threads` threads
+    // (hardware_concurrency if 0).  A single decoder can be shared by all CPU model runners so
+    // that they share the pool.
+    explicit CPUDecoder(size_t num_threads = 0);
+    ~CPUDecoder();
+
     std::vector<DecodedChunk> beam_search(const torch::Tensor& scores,
                                           int num_chunks,
                                           const DecoderOptions& options) final;
+
+    // Queues the decode of each of the first `num_chunks` chunks of `scores` on the pool and
+    // returns without waiting, so that the caller can prepare more work meanwhile.  Chunk i is
+    // written to `results[i]`, which must stay valid until `wait_for_decodes` has returned.
+    std::vector<std::future<void>> decode_async(const torch::Tensor& scores,
+                                                int num_chunks,
+                                                const DecoderOptions& options,
+                                                DecodedChunk* results);
+    // Waits for all of `futures`, then rethrows the first error any of them raised.
+    static void wait_for_decodes(std::vector<std::future<void>>& futures);
+
     constexpr static torch::ScalarType dtype = torch::kF32;
+
+private:
+    std::unique_ptr<cxxpool::thread_pool> m_pool;
 };
 
 }  // namespace dorado
@@ -11,9 +11,25 @@ struct DecodedChunk {
     std::string sequence;
     std::string qstring;
     std::vector<uint8_t> moves;
+    // Decoders may leave `qstring` empty and give the error probability of each base instead,
+    // so that qstrings are only generated for the bases kept once chunks are stitched.  The
+    // qscore calibration to apply when doing so is given alongside.
+    std::vector<float> base_error_probs;
+    float q_shift = 0.0;
+    float q_scale = 1.0;
+};
+
+enum class DecodeStrategy {
+    // Beam search guided by the forward/backward scan, with posterior-based qscores.
+    BeamSearch,
+    // Single best path from a forward max-plus pass with traceback.  Much cheaper, but less
+    // accurate, and qscores only see evidence up to each base so tend to be lower.  Only
+    // supported by the CPU decoder.
+    Viterbi,
 };
 
 struct DecoderOptions {
+    DecodeStrategy strategy = DecodeStrategy::BeamSearch;
     size_t beam_width = 32;
     float beam_cut = 100.0;
     float blank_score = 2.0;
@@ -25,6 +41,7 @@ struct DecoderOptions {
 
 class Decoder {
 public:
+    // Decodes with the strategy given in `options`.
     virtual std::vector<DecodedChunk> beam_search(const torch::Tensor& scores,
                                                   int num_chunks,
                                                   const DecoderOptions& options) = 0;
@@ -1,5 +1,7 @@
 #include "beam_search.h"
 
+#include "../utils/sequence_utils.h"
+#include "../utils/simd.h"
 #include "fast_hash.h"
 
 #include <math.h>
@@ -12,6 +14,8 @@
 #include <iostream>
 #include <limits>
 #include <numeric>
+#include <type_traits>
+#include <vector>
 
 #define REMOVE_FIXED_BEAM_STAYS
 
@@ -22,6 +26,10 @@ typedef int16_t state_t;
 
 const int num_bases = 4;
 
+// Beam width below which duplicate candidates are found by direct comparison rather than via a
+//  hash table.
+const size_t kMaxDirectMergeWidth = 16;
+
 // This is the data we need to retain for the whole beam
 struct BeamElement {
     state_t state;
@@ -30,13 +38,82 @@ struct BeamElement {
 };
 
 // This is the data we need to retain for only the previous timestep (block) in the beam
-//  (and what we construct for the new timestep)
-struct BeamFrontElement {
-    uint64_t hash;
-    float score;
-    state_t state;
-    uint8_t prev_element_index;
-    bool stay;
+//  (and what we construct for the new timestep), laid out as a structure of arrays so that
+//  candidate generation and score scans work on contiguous data.
+struct BeamFront {
+    explicit BeamFront(size_t capacity)
+            : hash(capacity),
+              parent_hash(capacity),
+              score(capacity),
+              state(capacity),
+              prev_element_index(capacity),
+              stay(capacity) {}
+
+    std::vector<uint64_t> hash;
+    // Hash of the sequence without its latest base.
+    std::vector<uint64_t> parent_hash;
+    std::vector<float> score;
+    std::vector<int32_t> state;
+    std::vector<uint8_t> prev_element_index;
+    std::vector<uint8_t> stay;
+};
+
+// Small open-addressed hash table (linear probing) mapping sequence hashes to candidate indices
+//  within a beam front.  Each distinct hash occupies one slot, with candidates sharing that hash
+//  chained from it, so probe lengths stay short even when the beam holds duplicate sequences.
+class CandidateHashTable {
+public:
+    explicit CandidateHashTable(size_t max_entries)
+            : m_hashes(table_capacity(max_entries)),
+              m_heads(table_capacity(max_entries), kEmpty),
+              m_next(max_entries) {}
+
+    // Empties the table, sizing it for `num_entries` insertions.  Beams are usually much narrower
+    //  than their maximum width, so only the slots needed are cleared.
+    void reset(size_t num_entries) {
+        const size_t capacity = table_capacity(num_entries);
+        m_mask = capacity - 1;
+        std::fill(m_heads.begin(), m_heads.begin() + capacity, kEmpty);
+    }
+
+    // Candidates with equal hashes are visited in the reverse of their insertion order.
+    void insert(uint64_t hash, int32_t index) {
+        size_t slot = size_t(hash) & m_mask;
+        while (m_heads[slot] != kEmpty && m_hashes[slot] != hash) {
+            slot = (slot + 1) & m_mask;
+        }
+        m_next[index] = m_heads[slot];
+        m_hashes[slot] = hash;
+        m_heads[slot] = index;
+    }
+
+    template <typename F>
+    void for_each_match(uint64_t hash, F&& func) const {
+        for (size_t slot = size_t(hash) & m_mask; m_heads[slot] != kEmpty;
+             slot = (slot + 1) & m_mask) {
+            if (m_hashes[slot] == hash) {
+                for (int32_t index = m_heads[slot]; index != kEmpty; index = m_next[index]) {
+                    func(index);
+                }
+                return;
+            }
+        }
+    }
+
+private:
+    static size_t table_capacity(size_t num_entries) {
+        size_t capacity = 16;
+        while (capacity < 2 * num_entries) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    static constexpr int32_t kEmpty = -1;
+    size_t m_mask = 0;
+    std::vector<uint64_t> m_hashes;
+    std::vector<int32_t> m_heads;
+    std::vector<int32_t> m_next;
 };
 
 float log_sum_exp(float x, float y, float t) {
@@ -44,7 +121,13 @@ float log_sum_exp(float x, float y, float t) {
     return fmaxf(x, y) + ((abs_diff < 17.0f) ? (log1pf(expf(-abs_diff)) * t) : 0.0f);
 }
 
-bool score_sort(const BeamFrontElement& a, const BeamFrontElement& b) { return a.score > b.score; }
+size_t count_at_least(const float* const scores, size_t count, float threshold) {
+    size_t num_at_least = 0;
+    for (size_t i = 0; i < count; i++) {
+        num_at_least += (scores[i] >= threshold) ? 1 : 0;
+    }
+    return num_at_least;
+}
 
 int get_num_states(size_t num_trans_states) {
 #ifdef REMOVE_FIXED_BEAM_STAYS
@@ -60,56 +143,130 @@ int get_num_states(size_t num_trans_states) {
 #endif
 }
 
-std::tuple<std::string, std::string> generate_sequence(const std::vector<uint8_t>& moves,
-                                                       const std::vector<int32_t>& states,
-                                                       const std::vector<float>& qual_data,
-                                                       float shift,
-                                                       float scale) {
-    size_t seqPos = 0;
-    size_t num_blocks = moves.size();
-    size_t seqLen = accumulate(moves.begin(), moves.end(), 0);
-
-    std::string sequence(seqLen, 'N');
-    std::string qstring(seqLen, '!');
-    std::array<char, 4> alphabet = {'A', 'C', 'G', 'T'};
-    std::vector<float> baseProbs(seqLen), totalProbs(seqLen);
-
+// Expands the called path into its sequence, and gives each base the error probability implied
+//  by the posteriors in `qual_data`.  Qstrings are generated from these separately, so that
+//  callers can leave that until chunks have been stitched.
+std::string generate_sequence(const std::vector<uint8_t>& moves,
+                              const std::vector<int32_t>& states,
+                              const std::vector<float>& qual_data,
+                              std::vector<float>& base_error_probs) {
+    static constexpr std::array<char, num_bases> alphabet = {'A', 'C', 'G', 'T'};
+    const size_t num_blocks = moves.size();
+    const size_t seq_len = std::accumulate(moves.begin(), moves.end(), size_t(0));
+
+    std::string sequence;
+    sequence.reserve(seq_len);
+    // Any position which no block's probabilities fall on has an undefined error probability.
+    base_error_probs.assign(seq_len, std::numeric_limits<float>::quiet_NaN());
+
+    // Each block's probabilities go to the last base it emits, or for a stay, to the base it
+    //  stays on.  Positions therefore only ever increase, so each one's sums can be completed
+    //  before moving on, rather than being accumulated in per-base buffers.
+    size_t prob_pos = 0;
+    float base_prob = 0.0f;
+    float total_prob = 0.0f;
     for (size_t blk = 0; blk < num_blocks; ++blk) {
-        int state = states[blk];
-        int move = int(moves[blk]);
-        int base = state & 3;
-        int offset = (blk == 0) ? 0 : move - 1;
-        int probPos = int(seqPos) + offset;
-
-        // Get the probability for the called base.
-        baseProbs[probPos] += qual_data[blk * alphabet.size() + base];
-
-        // Accumulate the total probability for all possible bases at this position, for normalization.
-        for (size_t k = 0; k < alphabet.size(); ++k) {
-            totalProbs[probPos] += qual_data[blk * alphabet.size() + k];
+        const int base = states[blk] & 3;
+        // Always step in the first block.
+        const size_t move = (blk == 0) ? 1 : moves[blk];
+        const size_t block_pos = sequence.size() + move - 1;
+        if (block_pos != prob_pos) {
+            base_error_probs[prob_pos] = 1.0f - base_prob / total_prob;
+            prob_pos = block_pos;
+            base_prob = 0.0f;
+            total_prob = 0.0f;
         }
+        sequence.append(move, alphabet[base]);
 
-        if (blk == 0) {
-            sequence[seqPos++] = char(base);
-        } else {
-            for (int j = 0; j < move; ++j) {
-                sequence[seqPos++] = char(base);
-            }
+        const float* const block_qual = qual_data.data() + blk * num_bases;
+        base_prob += block_qual[base];
+        for (size_t k = 0; k < num_bases; ++k) {
+            total_prob += block_qual[k];
         }
     }
+    if (seq_len != 0) {
+        base_error_probs[prob_pos] = 1.0f - base_prob / total_prob;
+    }
+
+    return sequence;
+}
 
-    for (size_t i = 0; i < seqLen; ++i) {
-        sequence[i] = alphabet[int(sequence[i])];
-        baseProbs[i] = 1.0f - (baseProbs[i] / totalProbs[i]);
-        baseProbs[i] = -10.0f * log10f(baseProbs[i]);
-        float qscore = baseProbs[i] * scale + shift;
-        qscore = std::min(50.0f, qscore);
-        qscore = std::max(1.0f, qscore);
-        qstring[i] = char(33.5f + qscore);
+#ifdef REMOVE_FIXED_BEAM_STAYS
+// Generates the scores and states of the `num_bases` step candidates extending each of the
+//  `width` elements of the previous beam front, from float scores.  Candidate
+//  `prev_elem_idx * num_bases + new_base` appends `new_base` to previous element
+//  `prev_elem_idx`.  `num_states` must be a power of `num_bases`.
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void expand_step_scores(const float* const block_scores,
+                        const float* const block_back_scores,
+                        const int32_t* const prev_states,
+                        const float* const prev_scores,
+                        size_t width,
+                        size_t num_states,
+                        float* const out_scores,
+                        int32_t* const out_states) {
+    for (size_t prev_elem_idx = 0; prev_elem_idx < width; prev_elem_idx++) {
+        const int32_t prev_state = prev_states[prev_elem_idx];
+        for (size_t new_base = 0; new_base < num_bases; new_base++) {
+            const int32_t new_state = int32_t((prev_state * num_bases) % num_states + new_base);
+            const int32_t move_idx =
+                    int32_t(new_state * num_bases + (prev_state * num_bases) / num_states);
+            const size_t elem_idx = prev_elem_idx * num_bases + new_base;
+            out_scores[elem_idx] = prev_scores[prev_elem_idx] + block_scores[move_idx] +
+                                   block_back_scores[new_state];
+            out_states[elem_idx] = new_state;
+        }
     }
+}
 
-    return make_tuple(sequence, qstring);
+#if ENABLE_AVX2_IMPL
+// The 4 steps from a previous element lead to consecutive states, so their back guides are
+//  contiguous and their transition scores lie at a stride of 4 within 16 contiguous floats.
+//  These are selected with permutes rather than gathers, which are slow on many CPUs.  The
+//  additions are performed in the same order as the scalar version, so results are identical.
+__attribute__((target("avx2"))) void expand_step_scores(const float* const block_scores,
+                                                       const float* const block_back_scores,
+                                                       const int32_t* const prev_states,
+                                                       const float* const prev_scores,
+                                                       size_t width,
+                                                       size_t num_states,
+                                                       float* const out_scores,
+                                                       int32_t* const out_states) {
+    // num_states == num_bases^k, so the modulo and division by num_states become a mask and a
+    //  shift.
+    int state_bits = 0;
+    while ((size_t(1) << state_bits) < num_states) {
+        state_bits++;
+    }
+    const int32_t state_mask = int32_t(num_states - 1);
+    const __m128i new_bases = _mm_setr_epi32(0, 1, 2, 3);
+
+    for (size_t prev_elem_idx = 0; prev_elem_idx < width; prev_elem_idx++) {
+        const int32_t prev_state = prev_states[prev_elem_idx];
+        const int32_t first_state = (prev_state << 2) & state_mask;
+        const int32_t msb = prev_state >> (state_bits - 2);
+
+        // Transition scores for first_state + new_base are at (first_state + new_base) * 4 + msb.
+        const float* const move_scores_base = block_scores + first_state * num_bases;
+        const __m256i select = _mm256_setr_epi32(msb, msb + 4, msb, msb + 4, msb, msb + 4, msb,
+                                                 msb + 4);
+        const __m256 lo = _mm256_permutevar8x32_ps(_mm256_loadu_ps(move_scores_base), select);
+        const __m256 hi = _mm256_permutevar8x32_ps(_mm256_loadu_ps(move_scores_base + 8), select);
+        const __m128 move_scores = _mm256_castps256_ps128(_mm256_blend_ps(lo, hi, 0b1100));
+
+        const __m128 back_scores = _mm_loadu_ps(block_back_scores + first_state);
+        const __m128 new_score = _mm_add_ps(
+                _mm_add_ps(_mm_set1_ps(prev_scores[prev_elem_idx]), move_scores), back_scores);
+
+        _mm_storeu_ps(out_scores + prev_elem_idx * num_bases, new_score);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out_states + prev_elem_idx * num_bases),
+                         _mm_add_epi32(_mm_set1_epi32(first_state), new_bases));
+    }
 }
+#endif  // ENABLE_AVX2_IMPL
+#endif  // REMOVE_FIXED_BEAM_STAYS
 
 }  // anonymous namespace
 
@@ -144,22 +301,26 @@ float beam_search(const T* const scores,
     // Each existing element can be extended by one of num_bases, or be a stay.
     size_t max_beam_candidates = (num_bases + 1) * max_beam_width;
 
-    std::vector<BeamFrontElement> beam_front_vector_1(max_beam_candidates);
-    std::vector<BeamFrontElement> beam_front_vector_2(max_beam_candidates);
-    std::vector<BeamFrontElement>* current_beam_front = &beam_front_vector_1;
-    std::vector<BeamFrontElement>* prev_beam_front = &beam_front_vector_2;
+    BeamFront current_beam_front(max_beam_candidates);
+    BeamFront prev_beam_front(max_beam_width);
+
+    // Hashes of the previous beam front, used to find steps which duplicate a stay
+    CandidateHashTable prev_hashes(max_beam_width);
+
+    // Scratch space for selecting the highest scoring candidates
+    std::vector<float> selection_scores(max_beam_candidates);
 
     // Find the score an initial element needs in order to make it into the beam
-    T beam_init_threshold = std::numeric_limits<T>::lowest();
+    // Back guides are floats whatever the type of the scores.
+    float beam_init_threshold = std::numeric_limits<float>::lowest();
     if (max_beam_width < num_states) {
         // Copy the first set of back guides and sort to extract max_beam_width highest elements
-        std::vector<T> sorted_back_guides(num_states);
-        memcpy(sorted_back_guides.data(), back_guide, num_states * sizeof(T));
+        std::vector<float> sorted_back_guides(back_guide, back_guide + num_states);
 
         // Note we don't need a full sort here to get the max_beam_width highest values
         std::nth_element(sorted_back_guides.begin(),
                          sorted_back_guides.begin() + max_beam_width - 1, sorted_back_guides.end(),
-                         std::greater<T>());
+                         std::greater<float>());
         beam_init_threshold = sorted_back_guides[max_beam_width - 1];
     }
 
@@ -168,18 +329,23 @@ float beam_search(const T* const scores,
          state++) {
         if (back_guide[state] >= beam_init_threshold) {
             // Note that this first element has a prev_element_index of 0
-            (*prev_beam_front)[beam_element++] = {fasthash::chainfasthash64(hash_seed, state), 0.0f,
-                                                  state_t(state), 0, false};
+            prev_beam_front.hash[beam_element] = fasthash::chainfasthash64(hash_seed, state);
+            prev_beam_front.parent_hash[beam_element] = hash_seed;
+            prev_beam_front.score[beam_element] = 0.0f;
+            prev_beam_front.state[beam_element] = int32_t(state);
+            prev_beam_front.prev_element_index[beam_element] = 0;
+            prev_beam_front.stay[beam_element] = false;
+            beam_element++;
         }
     }
 
     // Copy this initial beam front into the beam persistent state
     size_t current_beam_width = std::min(max_beam_width, num_states);
     for (size_t element_idx = 0; element_idx < current_beam_width; element_idx++) {
-        beam_vector[element_idx].state = (*prev_beam_front)[element_idx].state;
+        beam_vector[element_idx].state = state_t(prev_beam_front.state[element_idx]);
         beam_vector[element_idx].prev_element_index =
-                (*prev_beam_front)[element_idx].prev_element_index;
-        beam_vector[element_idx].stay = (*prev_beam_front)[element_idx].stay;
+                prev_beam_front.prev_element_index[element_idx];
+        beam_vector[element_idx].stay = prev_beam_front.stay[element_idx];
     }
 
     // Iterate through blocks, extending beam
@@ -205,9 +371,9 @@ float beam_search(const T* const scores,
 	 *
 	 *  Transition (movement) ACGTT (111) -> CGTTG (446) has index 446 * 4 + 0 = 1784
 	 */
-        auto generate_move_index = [](state_t previous_state, state_t new_state, size_t num_bases,
+        auto generate_move_index = [](int32_t previous_state, int32_t new_state, size_t num_bases,
                                       size_t num_states) {
-            return state_t(new_state * num_bases + ((previous_state * num_bases) / num_states));
+            return int32_t(new_state * num_bases + ((previous_state * num_bases) / num_states));
         };
 #else   // REMOVE_FIXED_BEAM_STAYS
         /*  kmer transitions order:
@@ -227,183 +393,196 @@ float beam_search(const T* const scores,
          *  Transition (stay) ACGTT (111) -> ACGTT (111) has index 111 * 5 + 0 = 555
          */
 
-        auto generate_move_index = [](state_t previous_state, state_t new_state, size_t num_bases,
+        auto generate_move_index = [](int32_t previous_state, int32_t new_state, size_t num_bases,
                                       size_t num_states) {
-            return state_t(new_state * (num_bases + 1) +
+            return int32_t(new_state * (num_bases + 1) +
                            (1 + (previous_state * num_bases) / num_states));
         };
-        auto generate_stay_index = [](state_t state, size_t num_bases) {
-            return state_t(state * (num_bases + 1));
+        auto generate_stay_index = [](int32_t state, size_t num_bases) {
+            return int32_t(state * (num_bases + 1));
         };
 #endif  // REMOVE_FIXED_BEAM_STAYS
 
-        // Generate list of candidate elements for this timestep (block)
-        size_t new_elem_count = 0;
-        for (size_t prev_elem_idx = 0; prev_elem_idx < current_beam_width; prev_elem_idx++) {
-            const auto& previous_element = (*prev_beam_front)[prev_elem_idx];
-
-            // Expand all the possible steps
-            for (size_t new_base = 0; new_base < num_bases; new_base++) {
-                state_t new_state =
-                        state_t((previous_element.state * num_bases) % num_states + new_base);
-                const state_t move_idx = generate_move_index(previous_element.state, new_state,
-                                                             num_bases, num_states);
-                float new_score = previous_element.score + fetch_block_score(move_idx) +
-                                  static_cast<float>(block_back_scores[new_state]);
-                uint64_t new_hash = fasthash::chainfasthash64(previous_element.hash, new_state);
-
-                // Add new element to the candidate list
-                (*current_beam_front)[new_elem_count++] = {new_hash, new_score, new_state,
-                                                           (uint8_t)prev_elem_idx, false};
+        // Generate list of candidate elements for this timestep (block).
+        // Steps come first, with candidate prev_elem_idx * num_bases + new_base...
+        const size_t num_steps = num_bases * current_beam_width;
+#ifdef REMOVE_FIXED_BEAM_STAYS
+        // Float scores are never rescaled (score_scale is 1), so use the vectorised expansion.
+        if constexpr (std::is_same_v<T, float>) {
+            expand_step_scores(block_scores, block_back_scores, prev_beam_front.state.data(),
+                               prev_beam_front.score.data(), current_beam_width, num_states,
+                               current_beam_front.score.data(), current_beam_front.state.data());
+        } else
+#endif
+        {
+            for (size_t prev_elem_idx = 0; prev_elem_idx < current_beam_width; prev_elem_idx++) {
+                const int32_t prev_state = prev_beam_front.state[prev_elem_idx];
+                for (size_t new_base = 0; new_base < num_bases; new_base++) {
+                    const int32_t new_state =
+                            int32_t((prev_state * num_bases) % num_states + new_base);
+                    const int32_t move_idx =
+                            generate_move_index(prev_state, new_state, num_bases, num_states);
+                    const size_t elem_idx = prev_elem_idx * num_bases + new_base;
+                    current_beam_front.score[elem_idx] = prev_beam_front.score[prev_elem_idx] +
+                                                         fetch_block_score(move_idx) +
+                                                         block_back_scores[new_state];
+                    current_beam_front.state[elem_idx] = new_state;
+                }
             }
         }
+        for (size_t elem_idx = 0; elem_idx < num_steps; elem_idx++) {
+            const size_t prev_elem_idx = elem_idx / num_bases;
+            current_beam_front.hash[elem_idx] = fasthash::chainfasthash64(
+                    prev_beam_front.hash[prev_elem_idx], current_beam_front.state[elem_idx]);
+            current_beam_front.parent_hash[elem_idx] = prev_beam_front.hash[prev_elem_idx];
+            current_beam_front.prev_element_index[elem_idx] = uint8_t(prev_elem_idx);
+            current_beam_front.stay[elem_idx] = false;
+        }
 
+        // ...followed by one stay per previous element.
         for (size_t prev_elem_idx = 0; prev_elem_idx < current_beam_width; prev_elem_idx++) {
-            const auto& previous_element = (*prev_beam_front)[prev_elem_idx];
+            const int32_t prev_state = prev_beam_front.state[prev_elem_idx];
             // Add the possible stay
 #ifdef REMOVE_FIXED_BEAM_STAYS
-            const float stay_score = previous_element.score + fixed_stay_score +
-                                     static_cast<float>(block_back_scores[previous_element.state]);
+            const float stay_score = prev_beam_front.score[prev_elem_idx] + fixed_stay_score +
+                                     block_back_scores[prev_state];
 #else
-            const state_t stay_idx = generate_stay_index(previous_element.state, num_bases);
-            const float stay_score = previous_element.score + fetch_block_score(stay_idx) +
-                                     static_cast<float>(block_back_scores[previous_element.state]);
+            const int32_t stay_idx = generate_stay_index(prev_state, num_bases);
+            const float stay_score = prev_beam_front.score[prev_elem_idx] +
+                                     fetch_block_score(stay_idx) + block_back_scores[prev_state];
 #endif
-            (*current_beam_front)[new_elem_count++] = {previous_element.hash, stay_score,
-                                                       previous_element.state,
-                                                       (uint8_t)prev_elem_idx, true};
+            const size_t elem_idx = num_steps + prev_elem_idx;
+            current_beam_front.hash[elem_idx] = prev_beam_front.hash[prev_elem_idx];
+            current_beam_front.parent_hash[elem_idx] = prev_beam_front.parent_hash[prev_elem_idx];
+            current_beam_front.score[elem_idx] = stay_score;
+            current_beam_front.state[elem_idx] = prev_state;
+            current_beam_front.prev_element_index[elem_idx] = uint8_t(prev_elem_idx);
+            current_beam_front.stay[elem_idx] = true;
         }
-
-        // For each new stay, see if any steps result in the same sequence hash, and merge if so
-        for (size_t prev_elem_idx = 0; prev_elem_idx < current_beam_width; prev_elem_idx++) {
-            // The index of the stay in the beamfront
-            size_t stay_elem_idx = num_bases * current_beam_width + prev_elem_idx;
-            // latest base is in smallest bits
-            int stay_latest_base = int((*current_beam_front)[stay_elem_idx].state % num_bases);
-
-            // Go through all the possible step extensions that match this destination base with the stay and compare
-            //  their hashes, merging if we find any
-            for (size_t prev_elem_comp_idx = 0; prev_elem_comp_idx < current_beam_width;
-                 prev_elem_comp_idx++) {
-                size_t step_elem_idx = prev_elem_comp_idx * num_bases + stay_latest_base;
-                if ((*current_beam_front)[stay_elem_idx].hash ==
-                    (*current_beam_front)[step_elem_idx].hash) {
-                    if ((*current_beam_front)[stay_elem_idx].score >
-                        (*current_beam_front)[step_elem_idx].score) {
-                        // Fold the step into the stay
-                        (*current_beam_front)[stay_elem_idx].score = log_sum_exp(
-                                (*current_beam_front)[stay_elem_idx].score,
-                                (*current_beam_front)[step_elem_idx].score, temperature);
-                        // The step element will end up last, sorted by score
-                        (*current_beam_front)[step_elem_idx].score =
-                                -std::numeric_limits<float>::max();
-                    } else {
-                        // Fold the stay into the step
-                        (*current_beam_front)[step_elem_idx].score = log_sum_exp(
-                                (*current_beam_front)[stay_elem_idx].score,
-                                (*current_beam_front)[step_elem_idx].score, temperature);
-                        // The stay element will end up last, sorted by score
-                        (*current_beam_front)[stay_elem_idx].score =
-                                -std::numeric_limits<float>::max();
-                    }
+        const size_t new_elem_count = num_steps + current_beam_width;
+
+        // For each new stay, see if any steps result in the same sequence hash, and merge if so.
+        //  Only a step appending the stay's latest base can match.
+        float* const candidate_scores = current_beam_front.score.data();
+        const auto merge_if_duplicate = [&](size_t stay_elem_idx, size_t step_elem_idx) {
+            if (current_beam_front.hash[stay_elem_idx] != current_beam_front.hash[step_elem_idx]) {
+                return;
+            }
+            float& stay_score = candidate_scores[stay_elem_idx];
+            float& step_score = candidate_scores[step_elem_idx];
+            if (stay_score > step_score) {
+                // Fold the step into the stay
+                stay_score = log_sum_exp(stay_score, step_score, temperature);
+                // The step element will now fall below any cutoff
+                step_score = -std::numeric_limits<float>::max();
+            } else {
+                // Fold the stay into the step
+                step_score = log_sum_exp(stay_score, step_score, temperature);
+                // The stay element will now fall below any cutoff
+                stay_score = -std::numeric_limits<float>::max();
+            }
+        };
+        if (current_beam_width <= kMaxDirectMergeWidth) {
+            // Narrow beams: comparing against every candidate step is cheapest.
+            for (size_t prev_elem_idx = 0; prev_elem_idx < current_beam_width; prev_elem_idx++) {
+                const size_t stay_elem_idx = num_steps + prev_elem_idx;
+                // latest base is in smallest bits
+                const int stay_latest_base =
+                        int(current_beam_front.state[stay_elem_idx] % num_bases);
+                for (size_t prev_elem_comp_idx = 0; prev_elem_comp_idx < current_beam_width;
+                     prev_elem_comp_idx++) {
+                    merge_if_duplicate(stay_elem_idx,
+                                       prev_elem_comp_idx * num_bases + stay_latest_base);
                 }
             }
+        } else {
+            // Wide beams: a matching step must extend an element whose hash is the stay's parent
+            //  hash, so look those up in a table of the previous front (filled in reverse so
+            //  that matches are visited in element order, as above).
+            prev_hashes.reset(current_beam_width);
+            for (size_t prev_elem_idx = current_beam_width; prev_elem_idx != 0; prev_elem_idx--) {
+                prev_hashes.insert(prev_beam_front.hash[prev_elem_idx - 1],
+                                   int32_t(prev_elem_idx - 1));
+            }
+            for (size_t prev_elem_idx = 0; prev_elem_idx < current_beam_width; prev_elem_idx++) {
+                const size_t stay_elem_idx = num_steps + prev_elem_idx;
+                const int stay_latest_base =
+                        int(current_beam_front.state[stay_elem_idx] % num_bases);
+                prev_hashes.for_each_match(prev_beam_front.parent_hash[prev_elem_idx],
+                                           [&](int32_t prev_elem_comp_idx) {
+                                               merge_if_duplicate(
+                                                       stay_elem_idx,
+                                                       prev_elem_comp_idx * num_bases +
+                                                               stay_latest_base);
+                                           });
+            }
         }
 
         // There are now `new_elem_count` elements in the list.  Let's get the max
-        float max_score = -std::numeric_limits<float>::max();
-        for (size_t elem_idx = 0; elem_idx < new_elem_count; elem_idx++) {
-            if ((*current_beam_front)[elem_idx].score > max_score)
-                max_score = (*current_beam_front)[elem_idx].score;
-        }
+        const float max_score =
+                *std::max_element(candidate_scores, candidate_scores + new_elem_count);
 
         // Starting point for finding the cutoff score is the beam cut score
         float beam_cutoff_score = max_score - log_beam_cut;
 
-        auto get_elem_count = [](const std::vector<BeamFrontElement>* current_beam_front,
-                                 size_t new_elem_count, float beam_score) {
-            // Count the elements which meet the beam score
-            size_t count = 0;
-            for (size_t elem_idx = 0; elem_idx < new_elem_count; elem_idx++) {
-                if ((*current_beam_front)[elem_idx].score >= beam_score)
-                    count++;
-            }
-            return count;
-        };
-
-        // Count the elements which meet the min score
-        size_t elem_count = get_elem_count(current_beam_front, new_elem_count, beam_cutoff_score);
-
-        if (elem_count > max_beam_width) {
-            // Need to find a score which doesn't return too many scores, but doesn't reduce beam width too much
-            size_t min_beam_width =
-                    (max_beam_width * 8) / 10;  // 80% of beam width is the minimum we accept.
-            float low_score = beam_cutoff_score;
-            float hi_score = max_score;
-            int num_guesses = 1;
-            static const int MAX_GUESSES = 10;
-            while ((elem_count > max_beam_width || elem_count < min_beam_width) &&
-                   num_guesses < MAX_GUESSES) {
-                if (elem_count > max_beam_width) {
-                    // Make a higher guess
-                    low_score = beam_cutoff_score;
-                    beam_cutoff_score = (beam_cutoff_score + hi_score) / 2.0f;  // binary search.
-                } else {
-                    // Make a lower guess
-                    hi_score = beam_cutoff_score;
-                    beam_cutoff_score = (beam_cutoff_score + low_score) / 2.0f;  // binary search.
-                }
-                elem_count = get_elem_count(current_beam_front, new_elem_count, beam_cutoff_score);
-                num_guesses++;
-            }
-            // If we made 10 guesses and didn't find a suitable score, a couple of things may have happened:
-            // 1: we just haven't completed the binary search yet (there is a good score in there somewhere but we didn't find it.)
-            //  - in this case we should just pick the higher of the two current search limits to get the top N elements)
-            // 2: there is no good score, as max_score returns more than beam_width elements (i.e. more than the whole beam width has max_score)
-            //  - in this case we should just take max_beam_width of the top-scoring elements
-            // 3: there is no good score as all the elements from <80% of the beam to >100% have the same score.
-            //  - in this case we should just take the hi_score and accept it will return us less than 80% of the beam
-            if (num_guesses == MAX_GUESSES) {
-                beam_cutoff_score = hi_score;
-                elem_count = get_elem_count(current_beam_front, new_elem_count, beam_cutoff_score);
-            }
+        if (count_at_least(candidate_scores, new_elem_count, beam_cutoff_score) > max_beam_width) {
+            // Too many candidates survive the beam cut, so raise the cutoff to the score of the
+            //  max_beam_width'th best candidate.  A partial selection is enough for this.
+            std::copy(candidate_scores, candidate_scores + new_elem_count,
+                      selection_scores.begin());
+            std::nth_element(selection_scores.begin(),
+                             selection_scores.begin() + max_beam_width - 1,
+                             selection_scores.begin() + new_elem_count, std::greater<float>());
+            beam_cutoff_score = selection_scores[max_beam_width - 1];
         }
-        // Clamp the element count to the max beam width in case of failure 2 from above.
-        elem_count = std::min(elem_count, max_beam_width);
-
-        size_t write_idx = 0;
-        for (unsigned int read_idx = 0; read_idx < new_elem_count; read_idx++) {
-            if ((*current_beam_front)[read_idx].score >= beam_cutoff_score) {
-                if (write_idx < max_beam_width) {
-                    (*prev_beam_front)[write_idx] = (*current_beam_front)[read_idx];
-                    write_idx++;
-                }
-            }
+
+        // Compact the surviving candidates into the new beam front, keeping their order.  Ties
+        //  at the cutoff may still produce more than max_beam_width candidates, so clamp.
+        //  Every candidate is written, but only survivors advance the output position.
+        size_t elem_count = 0;
+        for (size_t read_idx = 0; read_idx < new_elem_count && elem_count < max_beam_width;
+             read_idx++) {
+            prev_beam_front.hash[elem_count] = current_beam_front.hash[read_idx];
+            prev_beam_front.parent_hash[elem_count] = current_beam_front.parent_hash[read_idx];
+            prev_beam_front.score[elem_count] = candidate_scores[read_idx];
+            prev_beam_front.state[elem_count] = current_beam_front.state[read_idx];
+            prev_beam_front.prev_element_index[elem_count] =
+                    current_beam_front.prev_element_index[read_idx];
+            prev_beam_front.stay[elem_count] = current_beam_front.stay[read_idx];
+            elem_count += (candidate_scores[read_idx] >= beam_cutoff_score) ? 1 : 0;
         }
 
-        // At the last timestep, we need to sort the prev_beam_front as the best path needs to be at the start
-        // NOTE: We only want the top score out, so the cutoff is set to 1
+        // At the last timestep, we need the best path to be at the start of the beam front
         if (block_idx == num_blocks - 1) {
-            merge_sort(prev_beam_front->data(), elem_count, 1, score_sort);
+            const size_t best_idx = std::distance(
+                    prev_beam_front.score.begin(),
+                    std::max_element(prev_beam_front.score.begin(),
+                                     prev_beam_front.score.begin() + elem_count));
+            std::swap(prev_beam_front.hash[0], prev_beam_front.hash[best_idx]);
+            std::swap(prev_beam_front.parent_hash[0], prev_beam_front.parent_hash[best_idx]);
+            std::swap(prev_beam_front.score[0], prev_beam_front.score[best_idx]);
+            std::swap(prev_beam_front.state[0], prev_beam_front.state[best_idx]);
+            std::swap(prev_beam_front.prev_element_index[0],
+                      prev_beam_front.prev_element_index[best_idx]);
+            std::swap(prev_beam_front.stay[0], prev_beam_front.stay[best_idx]);
         }
 
         size_t beam_offset = (block_idx + 1) * max_beam_width;
         for (size_t i = 0; i < elem_count; i++) {
             // Remove backwards contribution from score
-            (*prev_beam_front)[i].score -= float(block_back_scores[(*prev_beam_front)[i].state]);
+            prev_beam_front.score[i] -= block_back_scores[prev_beam_front.state[i]];
 
             // Copy this new beam front into the beam persistent state
-            beam_vector[beam_offset + i].state = (*prev_beam_front)[i].state;
-            beam_vector[beam_offset + i].prev_element_index =
-                    (*prev_beam_front)[i].prev_element_index;
-            beam_vector[beam_offset + i].stay = (*prev_beam_front)[i].stay;
+            beam_vector[beam_offset + i].state = state_t(prev_beam_front.state[i]);
+            beam_vector[beam_offset + i].prev_element_index = prev_beam_front.prev_element_index[i];
+            beam_vector[beam_offset + i].stay = prev_beam_front.stay[i];
         }
 
         current_beam_width = elem_count;
     }
 
     // Extract final score
-    const float final_score = (*prev_beam_front)[0].score;
+    const float final_score = prev_beam_front.score[0];
 
     // Write out sequence bases and move table
     moves.resize(num_blocks);
@@ -481,21 +660,18 @@ float beam_search(const T* const scores,
     return final_score;
 }
 
-std::tuple<std::string, std::string, std::vector<uint8_t>> beam_search_decode(
-        const torch::Tensor& scores_t,
-        const torch::Tensor& back_guides_t,
-        const torch::Tensor& posts_t,
-        size_t beam_width,
-        float beam_cut,
-        float fixed_stay_score,
-        float q_shift,
-        float q_scale,
-        float temperature,
-        float byte_score_scale) {
+std::tuple<std::string, std::vector<float>, std::vector<uint8_t>>
+beam_search_decode_error_probs(const torch::Tensor& scores_t,
+                               const torch::Tensor& back_guides_t,
+                               const torch::Tensor& posts_t,
+                               size_t beam_width,
+                               float beam_cut,
+                               float fixed_stay_score,
+                               float temperature,
+                               float byte_score_scale) {
     const int num_blocks = int(scores_t.size(0));
     const int num_states = get_num_states(scores_t.size(1));
 
-    std::string sequence, qstring;
     std::vector<int32_t> states(num_blocks);
     std::vector<uint8_t> moves(num_blocks);
     std::vector<float> qual_data(num_blocks * num_bases);
@@ -534,7 +710,170 @@ std::tuple<std::string, std::string, std::vector<uint8_t>> beam_search_decode(
                                  std::string(scores_t.dtype().name()));
     }
 
-    std::tie(sequence, qstring) = generate_sequence(moves, states, qual_data, q_shift, q_scale);
+    std::vector<float> base_error_probs;
+    auto sequence = generate_sequence(moves, states, qual_data, base_error_probs);
+
+    return std::make_tuple(std::move(sequence), std::move(base_error_probs), std::move(moves));
+}
+
+std::tuple<std::string, std::string, std::vector<uint8_t>> beam_search_decode(
+        const torch::Tensor& scores_t,
+        const torch::Tensor& back_guides_t,
+        const torch::Tensor& posts_t,
+        size_t beam_width,
+        float beam_cut,
+        float fixed_stay_score,
+        float q_shift,
+        float q_scale,
+        float temperature,
+        float byte_score_scale) {
+    auto [sequence, base_error_probs, moves] = beam_search_decode_error_probs(
+            scores_t, back_guides_t, posts_t, beam_width, beam_cut, fixed_stay_score, temperature,
+            byte_score_scale);
+    auto qstring = dorado::utils::qstring_from_error_probs(
+            base_error_probs.data(), base_error_probs.size(), q_shift, q_scale);
+
+    return std::make_tuple(std::move(sequence), std::move(qstring), std::move(moves));
+}
+
+namespace {
+
+// Finds the highest scoring path through the CRF with a max-plus forward pass, recording the
+//  best incoming transition of every state at every block, then tracing back from the best final
+//  state.  Fills in the same outputs as beam_search.
+float viterbi(const float* const scores,
+              size_t scores_block_stride,
+              size_t num_states,
+              size_t num_blocks,
+              float fixed_stay_score,
+              std::vector<int32_t>& states,
+              std::vector<uint8_t>& moves,
+              std::vector<float>& qual_data,
+              float temperature) {
+    // Traceback value for a stay; steps are recorded as the dropped (most significant) base.
+    constexpr uint8_t kStay = num_bases;
+    const size_t msb_stride = num_states / num_bases;
+
+    std::vector<float> fwd(num_states, 0.0f);
+    std::vector<float> next_fwd(num_states);
+    std::vector<uint8_t> traceback(num_blocks * num_states);
+    // The best path score ending in each base at each block, for qscores.
+    std::vector<float> base_scores(num_blocks * num_bases);
+
+    for (size_t block_idx = 0; block_idx < num_blocks; block_idx++) {
+        const float* const block_scores = scores + block_idx * scores_block_stride;
+        uint8_t* const block_traceback = traceback.data() + block_idx * num_states;
+        float* const block_base_scores = base_scores.data() + block_idx * num_bases;
+        std::fill(block_base_scores, block_base_scores + num_bases,
+                  -std::numeric_limits<float>::max());
+
+        for (size_t state = 0; state < num_states; state++) {
+#ifdef REMOVE_FIXED_BEAM_STAYS
+            float best_score = fwd[state] + fixed_stay_score;
+            const float* const step_scores = block_scores + state * num_bases;
+#else
+            float best_score = fwd[state] + block_scores[state * (num_bases + 1)];
+            const float* const step_scores = block_scores + state * (num_bases + 1) + 1;
+#endif
+            uint8_t best_move = kStay;
+            // Steps into this state come from the states which differ only in their oldest base.
+            const size_t prev_state_base = state / num_bases;
+            for (size_t msb = 0; msb < num_bases; msb++) {
+                const float step_score = fwd[prev_state_base + msb * msb_stride] + step_scores[msb];
+                if (step_score > best_score) {
+                    best_score = step_score;
+                    best_move = uint8_t(msb);
+                }
+            }
+            next_fwd[state] = best_score;
+            block_traceback[state] = best_move;
+            block_base_scores[state % num_bases] =
+                    std::max(block_base_scores[state % num_bases], best_score);
+        }
+        std::swap(fwd, next_fwd);
+    }
+
+    // Trace back from the best final state.
+    const auto best_state_it = std::max_element(fwd.begin(), fwd.end());
+    const float final_score = *best_state_it;
+    size_t state = std::distance(fwd.begin(), best_state_it);
+
+    moves.resize(num_blocks);
+    states.resize(num_blocks);
+    for (size_t block_idx = num_blocks; block_idx != 0; block_idx--) {
+        states[block_idx - 1] = int32_t(state);
+        const uint8_t move = traceback[(block_idx - 1) * num_states + state];
+        moves[block_idx - 1] = (move == kStay) ? 0 : 1;
+        if (move != kStay) {
+            state = state / num_bases + move * msb_stride;
+        }
+    }
+    moves[0] = 1;  // Always step in the first event
+
+    // Without posteriors, the probability of the called base is approximated by a softmax over
+    //  the best paths ending in each base at this block, then treated as in beam_search.
+    for (size_t block_idx = 0; block_idx < num_blocks; block_idx++) {
+        const float* const block_base_scores = base_scores.data() + block_idx * num_bases;
+        const float max_score = *std::max_element(block_base_scores, block_base_scores + num_bases);
+        float total_prob = 0.0f;
+        for (size_t base = 0; base < num_bases; base++) {
+            total_prob += expf((block_base_scores[base] - max_score) / temperature);
+        }
+        const int base_to_emit = states[block_idx] % num_bases;
+        float block_prob =
+                expf((block_base_scores[base_to_emit] - max_score) / temperature) / total_prob;
+        block_prob = powf(block_prob, 0.4f);  // Power fudge factor
+
+        const float wrong_base_prob = (1.0f - block_prob) / 3.0f;
+        for (size_t base = 0; base < num_bases; base++) {
+            qual_data[block_idx * num_bases + base] =
+                    (int(base) == base_to_emit ? block_prob : wrong_base_prob);
+        }
+    }
+
+    return final_score;
+}
+
+}  // anonymous namespace
+
+std::tuple<std::string, std::vector<float>, std::vector<uint8_t>> viterbi_decode_error_probs(
+        const torch::Tensor& scores_t,
+        float fixed_stay_score,
+        float temperature) {
+    if (scores_t.dtype() != torch::kFloat32) {
+        throw std::runtime_error(std::string("viterbi_decode: unsupported tensor type ") +
+                                 std::string(scores_t.dtype().name()));
+    }
+
+    const int num_blocks = int(scores_t.size(0));
+    const int num_states = get_num_states(scores_t.size(1));
+
+    std::vector<int32_t> states(num_blocks);
+    std::vector<uint8_t> moves(num_blocks);
+    std::vector<float> qual_data(num_blocks * num_bases);
+
+    // scores_t may come from a tensor with chunks interleaved, but make sure the last dimension
+    // is contiguous
+    auto scores_block_contig = (scores_t.stride(1) == 1) ? scores_t : scores_t.contiguous();
+    viterbi(scores_block_contig.data_ptr<float>(), scores_block_contig.stride(0), num_states,
+            num_blocks, fixed_stay_score, states, moves, qual_data, temperature);
+
+    std::vector<float> base_error_probs;
+    auto sequence = generate_sequence(moves, states, qual_data, base_error_probs);
+
+    return std::make_tuple(std::move(sequence), std::move(base_error_probs), std::move(moves));
+}
+
+std::tuple<std::string, std::string, std::vector<uint8_t>> viterbi_decode(
+        const torch::Tensor& scores_t,
+        float fixed_stay_score,
+        float q_shift,
+        float q_scale,
+        float temperature) {
+    auto [sequence, base_error_probs, moves] =
+            viterbi_decode_error_probs(scores_t, fixed_stay_score, temperature);
+    auto qstring = dorado::utils::qstring_from_error_probs(
+            base_error_probs.data(), base_error_probs.size(), q_shift, q_scale);
 
-    return std::make_tuple(sequence, qstring, moves);
+    return std::make_tuple(std::move(sequence), std::move(qstring), std::move(moves));
 }
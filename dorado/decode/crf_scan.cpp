@@ -0,0 +1,308 @@
+#include "crf_scan.h"
+
+#include "../utils/simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t kNumBases = 4;
+constexpr size_t kNumTerms = kNumBases + 1;
+
+// out[i] = log(sum_k exp(terms[k * n + i])) for the kNumTerms rows of `terms`.
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void log_sum_exp_terms(const float* const terms, size_t n, float* const out) {
+    for (size_t i = 0; i < n; ++i) {
+        float max_val = terms[i];
+        for (size_t k = 1; k < kNumTerms; ++k) {
+            max_val = std::max(max_val, terms[k * n + i]);
+        }
+        float sum = 0.0f;
+        for (size_t k = 0; k < kNumTerms; ++k) {
+            sum += expf(terms[k * n + i] - max_val);
+        }
+        out[i] = max_val + logf(sum);
+    }
+}
+
+// In place softmax of `n` elements.
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void softmax(float* const x, size_t n) {
+    const float max_val = *std::max_element(x, x + n);
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = expf(x[i] - max_val);
+        sum += x[i];
+    }
+    const float inv_sum = 1.0f / sum;
+    for (size_t i = 0; i < n; ++i) {
+        x[i] *= inv_sum;
+    }
+}
+
+#if ENABLE_AVX2_IMPL
+// Cephes-style polynomial approximations of exp and log for 8 floats at once, accurate to a
+// couple of ulp over the ranges used here.
+__attribute__((target("avx2"))) inline __m256 exp_avx2(__m256 x) {
+    x = _mm256_min_ps(x, _mm256_set1_ps(88.3762626647949f));
+    x = _mm256_max_ps(x, _mm256_set1_ps(-88.3762626647949f));
+
+    // exp(x) = 2^n * exp(r), with n = round(x / ln2) and |r| <= ln2 / 2.
+    __m256 fx = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+                              _mm256_set1_ps(0.5f));
+    fx = _mm256_floor_ps(fx);
+    x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(0.693359375f)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(-2.12194440e-4f)));
+
+    __m256 y = _mm256_set1_ps(1.9875691500E-4f);
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.3981999507E-3f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(8.3334519073E-3f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(4.1665795894E-2f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.6666665459E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(5.0000001201E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, _mm256_mul_ps(x, x)), x);
+    y = _mm256_add_ps(y, _mm256_set1_ps(1.0f));
+
+    const __m256i pow2n = _mm256_slli_epi32(
+            _mm256_add_epi32(_mm256_cvttps_epi32(fx), _mm256_set1_epi32(0x7f)), 23);
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(pow2n));
+}
+
+// Only valid for positive, normal x, which holds for the sums of exponentials computed here.
+__attribute__((target("avx2"))) inline __m256 log_avx2(__m256 x) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    // Split x into exponent e and mantissa m in [0.5, 1).
+    __m256i exponent = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+    x = _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(~0x7f800000)));
+    x = _mm256_or_ps(x, _mm256_set1_ps(0.5f));
+    exponent = _mm256_sub_epi32(exponent, _mm256_set1_epi32(0x7f));
+    __m256 e = _mm256_add_ps(_mm256_cvtepi32_ps(exponent), one);
+
+    // Shift m into [sqrt(0.5), sqrt(2)) for better accuracy.
+    const __m256 mask = _mm256_cmp_ps(x, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OS);
+    const __m256 tmp = _mm256_and_ps(x, mask);
+    x = _mm256_sub_ps(x, one);
+    e = _mm256_sub_ps(e, _mm256_and_ps(one, mask));
+    x = _mm256_add_ps(x, tmp);
+
+    const __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(7.0376836292E-2f);
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.1514610310E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.1676998740E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.2420140846E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.4249322787E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-1.6668057665E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(2.0000714765E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(-2.4999993993E-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(3.3333331174E-1f));
+    y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+
+    y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440e-4f)));
+    y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+    x = _mm256_add_ps(x, y);
+    return _mm256_add_ps(x, _mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)));
+}
+
+__attribute__((target("avx2"))) inline float horizontal_max(__m256 x) {
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+    return _mm_cvtss_f32(m);
+}
+
+__attribute__((target("avx2"))) inline float horizontal_sum(__m256 x) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+__attribute__((target("avx2"))) void log_sum_exp_terms(const float* const terms,
+                                                      size_t n,
+                                                      float* const out) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 vals[kNumTerms];
+        vals[0] = _mm256_loadu_ps(terms + i);
+        __m256 max_val = vals[0];
+        for (size_t k = 1; k < kNumTerms; ++k) {
+            vals[k] = _mm256_loadu_ps(terms + k * n + i);
+            max_val = _mm256_max_ps(max_val, vals[k]);
+        }
+        __m256 sum = _mm256_setzero_ps();
+        for (size_t k = 0; k < kNumTerms; ++k) {
+            sum = _mm256_add_ps(sum, exp_avx2(_mm256_sub_ps(vals[k], max_val)));
+        }
+        _mm256_storeu_ps(out + i, _mm256_add_ps(max_val, log_avx2(sum)));
+    }
+    for (; i < n; ++i) {
+        float max_val = terms[i];
+        for (size_t k = 1; k < kNumTerms; ++k) {
+            max_val = std::max(max_val, terms[k * n + i]);
+        }
+        float sum = 0.0f;
+        for (size_t k = 0; k < kNumTerms; ++k) {
+            sum += expf(terms[k * n + i] - max_val);
+        }
+        out[i] = max_val + logf(sum);
+    }
+}
+
+__attribute__((target("avx2"))) void softmax(float* const x, size_t n) {
+    const size_t vec_n = n - n % 8;
+    __m256 max_vec = _mm256_set1_ps(-std::numeric_limits<float>::max());
+    for (size_t i = 0; i < vec_n; i += 8) {
+        max_vec = _mm256_max_ps(max_vec, _mm256_loadu_ps(x + i));
+    }
+    float max_val = horizontal_max(max_vec);
+    for (size_t i = vec_n; i < n; ++i) {
+        max_val = std::max(max_val, x[i]);
+    }
+
+    const __m256 max_bcast = _mm256_set1_ps(max_val);
+    __m256 sum_vec = _mm256_setzero_ps();
+    for (size_t i = 0; i < vec_n; i += 8) {
+        const __m256 e = exp_avx2(_mm256_sub_ps(_mm256_loadu_ps(x + i), max_bcast));
+        _mm256_storeu_ps(x + i, e);
+        sum_vec = _mm256_add_ps(sum_vec, e);
+    }
+    float sum = horizontal_sum(sum_vec);
+    for (size_t i = vec_n; i < n; ++i) {
+        x[i] = expf(x[i] - max_val);
+        sum += x[i];
+    }
+
+    const float inv_sum = 1.0f / sum;
+    const __m256 inv_sum_vec = _mm256_set1_ps(inv_sum);
+    for (size_t i = 0; i < vec_n; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), inv_sum_vec));
+    }
+    for (size_t i = vec_n; i < n; ++i) {
+        x[i] *= inv_sum;
+    }
+}
+#endif
+
+}  // namespace
+
+namespace dorado {
+
+CRFScan::CRFScan(size_t num_states)
+        : m_num_states(num_states),
+          m_fwd_prev_state(num_states * kNumBases),
+          m_bwd_next_state(num_states * kNumBases),
+          m_bwd_score_idx(num_states * kNumBases),
+          m_terms(num_states * kNumTerms) {
+    if (num_states < kNumBases || num_states % kNumBases != 0) {
+        throw std::runtime_error("CRFScan: unexpected number of states.");
+    }
+
+    // State indices are lexicographic with the most recent base in the fastest index, so a step
+    // drops the oldest base (the top digit) and appends the new base at the bottom.
+    const size_t msb_stride = num_states / kNumBases;
+    for (size_t state = 0; state < num_states; ++state) {
+        for (size_t base = 0; base < kNumBases; ++base) {
+            // The transition into `state` whose dropped base is `base`.
+            m_fwd_prev_state[state * kNumBases + base] =
+                    int32_t(base * msb_stride + state / kNumBases);
+
+            // The transition out of `state` appending `base`.
+            const size_t next_state = (state * kNumBases) % num_states + base;
+            m_bwd_next_state[state * kNumBases + base] = int32_t(next_state);
+            m_bwd_score_idx[state * kNumBases + base] =
+                    int32_t(next_state * kNumBases + state / msb_stride);
+        }
+    }
+}
+
+void CRFScan::forward(const float* const scores,
+                      size_t num_blocks,
+                      size_t block_stride,
+                      float stay) {
+    const size_t num_states = m_num_states;
+    float* const terms = m_terms.data();
+    const int32_t* const prev_state = m_fwd_prev_state.data();
+
+    // Forward scores are accumulated in the posts buffer, which is converted to probabilities
+    // in place once the backward scores are known.
+    float* alpha = m_posts.data();
+    std::fill_n(alpha, num_states, 0.0f);
+
+    for (size_t block = 0; block < num_blocks; ++block) {
+        const float* const block_scores = scores + block * block_stride;
+        float* const next_alpha = alpha + num_states;
+        for (size_t state = 0; state < num_states; ++state) {
+            terms[state] = alpha[state] + stay;
+            for (size_t base = 0; base < kNumBases; ++base) {
+                const size_t idx = state * kNumBases + base;
+                terms[(base + 1) * num_states + state] =
+                        alpha[prev_state[idx]] + block_scores[idx];
+            }
+        }
+        log_sum_exp_terms(terms, num_states, next_alpha);
+        alpha = next_alpha;
+    }
+}
+
+void CRFScan::backward(const float* const scores,
+                       size_t num_blocks,
+                       size_t block_stride,
+                       float stay) {
+    const size_t num_states = m_num_states;
+    float* const terms = m_terms.data();
+    const int32_t* const next_state = m_bwd_next_state.data();
+    const int32_t* const score_idx = m_bwd_score_idx.data();
+
+    float* beta = m_bwd.data() + num_blocks * num_states;
+    std::fill_n(beta, num_states, 0.0f);
+
+    for (size_t block = num_blocks; block-- > 0;) {
+        const float* const block_scores = scores + block * block_stride;
+        float* const prev_beta = beta - num_states;
+        for (size_t state = 0; state < num_states; ++state) {
+            terms[state] = beta[state] + stay;
+            for (size_t base = 0; base < kNumBases; ++base) {
+                const size_t idx = state * kNumBases + base;
+                terms[(base + 1) * num_states + state] =
+                        beta[next_state[idx]] + block_scores[score_idx[idx]];
+            }
+        }
+        log_sum_exp_terms(terms, num_states, prev_beta);
+        beta = prev_beta;
+    }
+}
+
+void CRFScan::run(const float* const scores,
+                  size_t num_blocks,
+                  size_t block_stride,
+                  float fixed_stay_score) {
+    const size_t num_states = m_num_states;
+    const size_t out_size = (num_blocks + 1) * num_states;
+    // Buffers only ever grow, so repeated calls with the same chunk size don't allocate.
+    if (m_bwd.size() < out_size) {
+        m_bwd.resize(out_size);
+        m_posts.resize(out_size);
+    }
+
+    forward(scores, num_blocks, block_stride, fixed_stay_score);
+    backward(scores, num_blocks, block_stride, fixed_stay_score);
+
+    for (size_t block = 0; block <= num_blocks; ++block) {
+        float* const posts = m_posts.data() + block * num_states;
+        const float* const bwd = m_bwd.data() + block * num_states;
+        for (size_t state = 0; state < num_states; ++state) {
+            posts[state] += bwd[state];
+        }
+        softmax(posts, num_states);
+    }
+}
+
+}  // namespace dorado
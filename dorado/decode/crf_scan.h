@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dorado {
+
+// Native forward/backward scan over the CRF transition scores of a single chunk, producing the
+// backward guides and per-state posterior probabilities needed by beam search.
+//
+// Scores for block t are `num_states * 4` floats starting at `scores + t * block_stride`, with
+// the 4 transitions into each state arranged along the innermost dimension, as output by the
+// CRF model.  Stays have the fixed score supplied.
+//
+// Output buffers are owned by the scanner and reused between calls, so a scanner should be kept
+// per decoding thread.
+class CRFScan {
+public:
+    explicit CRFScan(size_t num_states);
+
+    void run(const float* scores, size_t num_blocks, size_t block_stride, float fixed_stay_score);
+
+    // (num_blocks + 1) x num_states backward guides from the last call to `run`.
+    const float* back_guides() const { return m_bwd.data(); }
+    // (num_blocks + 1) x num_states posterior probabilities from the last call to `run`.
+    const float* posts() const { return m_posts.data(); }
+
+    size_t num_states() const { return m_num_states; }
+
+private:
+    void forward(const float* scores, size_t num_blocks, size_t block_stride, float stay);
+    void backward(const float* scores, size_t num_blocks, size_t block_stride, float stay);
+
+    size_t m_num_states;
+
+    // For each state and each of the 4 incoming step transitions, the preceding state.
+    std::vector<int32_t> m_fwd_prev_state;
+    // For each state and each of the 4 outgoing step transitions, the succeeding state and the
+    // index of that transition's score within a block.
+    std::vector<int32_t> m_bwd_next_state;
+    std::vector<int32_t> m_bwd_score_idx;
+
+    // The 5 terms (stay + 4 steps) feeding the log-sum-exp of each state at one timestep.
+    std::vector<float> m_terms;
+    std::vector<float> m_bwd;
+    std::vector<float> m_posts;
+};
+
+}  // namespace dorado
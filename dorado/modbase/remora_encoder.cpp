@@ -25,8 +25,8 @@ RemoraEncoder::RemoraEncoder(size_t block_stride,
 
 void RemoraEncoder::init(const std::vector<int>& sequence_ints,
                          const std::vector<uint64_t>& seq_to_sig_map) {
+    NVTX3_FUNC_RANGE();
     // gcc9 doesn't support <ranges>, which would be useful here
-    m_sequence_ints = sequence_ints;
     m_sample_offsets = {std::begin(seq_to_sig_map), std::end(seq_to_sig_map)};
 
     // last entry is the signal length
@@ -34,15 +34,53 @@ void RemoraEncoder::init(const std::vector<int>& sequence_ints,
 
     // cache sequence length
     m_seq_len = int(sequence_ints.size());
+
+    // A context starts at most m_context_samples / 2 samples before the signal, and ends at most
+    // that many plus half a block after it, since its centre may lie in the last, partial, block.
+    m_lead_samples = m_context_samples / 2;
+    const int tail_samples = m_context_samples - m_lead_samples + m_block_stride;
+
+    // Sequence with -1 padding for kmers which overlap either end of the read.
+    m_padded_seq_ints.assign(m_bases_before, -1);
+    m_padded_seq_ints.reserve(m_seq_len + m_bases_before + m_bases_after);
+    m_padded_seq_ints.insert(m_padded_seq_ints.end(), sequence_ints.begin(), sequence_ints.end());
+    m_padded_seq_ints.insert(m_padded_seq_ints.end(), m_bases_after, -1);
+
+    // The first and last bases are extended over the lead and tail padding.
+    m_padded_seq_to_sig.resize(m_sample_offsets.size());
+    std::transform(m_sample_offsets.begin(), m_sample_offsets.end(), m_padded_seq_to_sig.begin(),
+                   [this](int val) { return val + m_lead_samples; });
+    if (m_seq_len != 0) {
+        m_padded_seq_to_sig.front() = 0;
+        m_padded_seq_to_sig.back() += tail_samples;
+    }
+}
+
+torch::Tensor RemoraEncoder::encode_rows(size_t first_row, size_t num_rows) const {
+    NVTX3_FUNC_RANGE();
+    const int end_row = int(first_row + num_rows);
+    if (m_seq_len == 0 || end_row > m_padded_seq_to_sig.back()) {
+        throw std::out_of_range("Encoding rows out of range.");
+    }
+
+    auto encoded_kmers =
+            torch::empty({int64_t(num_rows), m_kmer_len * RemoraUtils::NUM_BASES}, torch::kInt8);
+    encode_kmer(int(first_row), end_row, encoded_kmers.data_ptr<int8_t>());
+    return encoded_kmers;
 }
 
 RemoraEncoder::Context RemoraEncoder::get_context(size_t seq_pos) const {
+    auto context = get_context_bounds(seq_pos);
+    context.data = encode_rows(context.encoding_row, m_context_samples);
+    return context;
+}
+
+RemoraEncoder::Context RemoraEncoder::get_context_bounds(size_t seq_pos) const {
     NVTX3_FUNC_RANGE();
     if (seq_pos >= size_t(m_seq_len)) {
         throw std::out_of_range("Sequence position out of range.");
     }
 
-    auto encoded_kmer_len = m_kmer_len * RemoraUtils::NUM_BASES;
     Context context{};
     int base_sample_pos =
             (compute_sample_pos(int(seq_pos)) + compute_sample_pos(int(seq_pos) + 1)) / 2;
@@ -64,47 +102,7 @@ RemoraEncoder::Context RemoraEncoder::get_context(size_t seq_pos) const {
         context.tail_samples_needed = 0;
     }
 
-    // find base position for first and last sample
-    auto start_it = std::upper_bound(m_sample_offsets.begin(), m_sample_offsets.end(),
-                                     context.first_sample);
-    auto end_it = std::lower_bound(m_sample_offsets.begin(), m_sample_offsets.end(),
-                                   context.first_sample + context.num_samples);
-
-    auto seq_start = std::distance(m_sample_offsets.begin(), start_it) - 1;
-    auto seq_end = std::distance(m_sample_offsets.begin(), end_it);
-
-    std::vector<int> seq_ints;
-
-    if (seq_start >= m_bases_before &&
-        seq_end + m_bases_after < static_cast<int>(m_sequence_ints.size())) {
-        seq_ints = {m_sequence_ints.begin() + seq_start - m_bases_before,
-                    m_sequence_ints.begin() + seq_end + m_bases_after};
-    } else {
-        seq_ints.insert(seq_ints.end(), seq_end - seq_start + m_bases_before + m_bases_after, -1);
-        auto fill_st = 0;
-        auto chunk_seq_st = seq_start - m_bases_before;
-        auto chunk_seq_en = seq_end + m_bases_after;
-        if (seq_start < m_bases_before) {
-            fill_st = m_bases_before - seq_start;
-            chunk_seq_st = 0;
-        }
-        if (seq_end + m_bases_after > static_cast<int>(m_sequence_ints.size())) {
-            chunk_seq_en = m_sequence_ints.size();
-        }
-        std::copy(m_sequence_ints.begin() + chunk_seq_st, m_sequence_ints.begin() + chunk_seq_en,
-                  seq_ints.begin() + fill_st);
-    }
-
-    std::vector<int> chunk_seq_to_sig = {m_sample_offsets.begin() + seq_start,
-                                         m_sample_offsets.begin() + seq_end + 1};
-    std::transform(
-            chunk_seq_to_sig.begin(), chunk_seq_to_sig.end(), chunk_seq_to_sig.begin(),
-            [sig_start = context.first_sample, seq_to_sig_offset = context.lead_samples_needed](
-                    auto val) { return val -= sig_start - seq_to_sig_offset; });
-    chunk_seq_to_sig.front() = 0;
-    chunk_seq_to_sig.back() = m_context_samples;
-
-    context.data = encode_kmer(seq_ints, chunk_seq_to_sig);
+    context.encoding_row = size_t(first_sample + m_lead_samples);
 
     return context;
 }
@@ -126,20 +124,28 @@ int RemoraEncoder::compute_sample_pos(int base_pos) const {
 
 namespace {
 
+// The first base with rows at or after `first_row`.
+inline size_t first_base_of_rows(const std::vector<int>& seq_mappings, int first_row) {
+    return std::upper_bound(seq_mappings.begin(), seq_mappings.end(), first_row) -
+           seq_mappings.begin() - 1;
+}
+
 // Fallback path for non-AVX / kmer lengths not specifically optimised.
-inline std::vector<int8_t> encode_kmer_generic(const std::vector<int>& seq,
-                                               const std::vector<int>& seq_mappings,
-                                               int bases_before,
-                                               int bases_after,
-                                               int context_samples,
-                                               int kmer_len) {
+inline void encode_kmer_generic(const std::vector<int>& seq,
+                                const std::vector<int>& seq_mappings,
+                                int bases_before,
+                                int bases_after,
+                                int kmer_len,
+                                int first_row,
+                                int end_row,
+                                int8_t* output) {
     const size_t seq_len = seq.size() - bases_before - bases_after;
-    std::vector<int8_t> output(kmer_len * RemoraUtils::NUM_BASES * context_samples);
 
-    int8_t* output_ptr = &output[0];
-    for (size_t seq_pos = 0; seq_pos < seq_len; ++seq_pos) {
-        auto base_st = seq_mappings[seq_pos];
-        auto base_en = seq_mappings[seq_pos + 1];
+    int8_t* output_ptr = output;
+    for (size_t seq_pos = first_base_of_rows(seq_mappings, first_row);
+         seq_pos < seq_len && seq_mappings[seq_pos] < end_row; ++seq_pos) {
+        auto base_st = std::max(seq_mappings[seq_pos], first_row);
+        auto base_en = std::min(seq_mappings[seq_pos + 1], end_row);
 
         for (int i = base_st; i < base_en; ++i) {
             for (size_t kmer_pos = 0; kmer_pos < kmer_len; ++kmer_pos) {
@@ -151,32 +157,33 @@ inline std::vector<int8_t> encode_kmer_generic(const std::vector<int>& seq,
             }
         }
     }
-    return output;
 }
 
 // For non-AVX we use the generic path that handles any kmer length.
 #if ENABLE_AVX2_IMPL
 __attribute__((target("default")))
 #endif
-std::vector<int8_t>
-encode_kmer_len9(const std::vector<int>& seq,
-                 const std::vector<int>& seq_mappings,
-                 int bases_before,
-                 int bases_after,
-                 int context_samples) {
-    return encode_kmer_generic(seq, seq_mappings, bases_before, bases_after, context_samples, 9);
+void encode_kmer_len9(const std::vector<int>& seq,
+                      const std::vector<int>& seq_mappings,
+                      int bases_before,
+                      int bases_after,
+                      int first_row,
+                      int end_row,
+                      int8_t* output) {
+    encode_kmer_generic(seq, seq_mappings, bases_before, bases_after, 9, first_row, end_row,
+                        output);
 }
 
 #if ENABLE_AVX2_IMPL
-__attribute__((target("avx2"))) std::vector<int8_t> encode_kmer_len9(
-        const std::vector<int>& seq,
-        const std::vector<int>& seq_mappings,
-        int bases_before,
-        int bases_after,
-        int context_samples) {
+__attribute__((target("avx2"))) void encode_kmer_len9(const std::vector<int>& seq,
+                                                      const std::vector<int>& seq_mappings,
+                                                      int bases_before,
+                                                      int bases_after,
+                                                      int first_row,
+                                                      int end_row,
+                                                      int8_t* output) {
     // These cannot change without a rewrite.
     constexpr int kKmerLen = 9;
-    constexpr int kNumBases = 4;
 
     const __m256i kOnes = _mm256_set_epi32(1, 1, 1, 1, 1, 1, 1, 1);
 
@@ -186,11 +193,11 @@ __attribute__((target("avx2"))) std::vector<int8_t> encode_kmer_len9(
     const __m256i kRotate3 = _mm256_setr_epi32(5, 6, 7, 0, 1, 2, 3, 4);
 
     const size_t seq_len = seq.size() - bases_before - bases_after;
-    std::vector<int8_t> output_t(kKmerLen * kNumBases * context_samples);
-    std::byte* output_t_ptr = reinterpret_cast<std::byte*>(&output_t[0]);
-    for (size_t seq_pos = 0; seq_pos < seq_len; ++seq_pos) {
-        const auto base_st = seq_mappings[seq_pos];
-        const auto base_en = seq_mappings[seq_pos + 1];
+    std::byte* output_t_ptr = reinterpret_cast<std::byte*>(output);
+    for (size_t seq_pos = first_base_of_rows(seq_mappings, first_row);
+         seq_pos < seq_len && seq_mappings[seq_pos] < end_row; ++seq_pos) {
+        const auto base_st = std::max(seq_mappings[seq_pos], first_row);
+        const auto base_en = std::min(seq_mappings[seq_pos + 1], end_row);
 
         // Load the 9 base indices with 2 overlapping 256 bit loads.
         const __m256i bases_01234567 =
@@ -255,22 +262,21 @@ __attribute__((target("avx2"))) std::vector<int8_t> encode_kmer_len9(
             output_t_ptr += 36;
         }
     }
-
-    return output_t;
 }
 #endif
 
 }  // namespace
 
-std::vector<int8_t> RemoraEncoder::encode_kmer(const std::vector<int>& seq,
-                                               const std::vector<int>& seq_mappings) const {
+void RemoraEncoder::encode_kmer(int first_row, int end_row, int8_t* output) const {
     // Specialised version for the case of kmer_len 9 that can be faster.
-    if (m_kmer_len == 9)
-        return encode_kmer_len9(seq, seq_mappings, m_bases_before, m_bases_after,
-                                m_context_samples);
+    if (m_kmer_len == 9) {
+        encode_kmer_len9(m_padded_seq_ints, m_padded_seq_to_sig, m_bases_before, m_bases_after,
+                         first_row, end_row, output);
+        return;
+    }
 
-    return encode_kmer_generic(seq, seq_mappings, m_bases_before, m_bases_after, m_context_samples,
-                               m_kmer_len);
+    encode_kmer_generic(m_padded_seq_ints, m_padded_seq_to_sig, m_bases_before, m_bases_after,
+                        m_kmer_len, first_row, end_row, output);
 }
 
 }  // namespace dorado
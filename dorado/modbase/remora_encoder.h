@@ -18,13 +18,19 @@ private:
 
     int m_seq_len;
     int m_signal_len;
-    std::vector<int> m_sequence_ints;
     std::vector<int> m_sample_offsets;
 
+    // The sequence padded with -1 for kmers which overlap either end of the read, and the first
+    // row of the encoding of each base.  The encoding has a row per sample, preceded by
+    // m_lead_samples rows for the first base and followed by enough rows for the last base to
+    // cover the padding of any context.
+    std::vector<int> m_padded_seq_ints;
+    std::vector<int> m_padded_seq_to_sig;
+    int m_lead_samples;
+
     int compute_sample_pos(int base_pos) const;
 
-    std::vector<int8_t> encode_kmer(const std::vector<int>& seq,
-                                    const std::vector<int>& seq_mappings) const;
+    void encode_kmer(int first_row, int end_row, int8_t* output) const;
 
 public:
     /** Encoder for Remora-style modified base detection.
@@ -35,7 +41,7 @@ public:
      */
     RemoraEncoder(size_t block_stride, size_t context_samples, int bases_before, int bases_after);
 
-    /** Initialize the sequence and movement map from which to generate encodings
+    /** Initialize the sequence and movement map from which to generate encodings.
      *  @param sequence_ints The basecall sequence encoded as integers (A=0, C=1, G=2, T=3)
      *  @param seq_to_sig_map An array indicating the position in the signal at which the corresponding base begins/the 
      *  previous base ends. The final value in the array should be the length of the signal. @see ::utils::moves_to_map
@@ -44,7 +50,8 @@ public:
 
     /// Helper structure for specifying the context and returning the corresponding encoded data.
     struct Context {
-        std::vector<int8_t> data;  ///< Encoded data slice
+        torch::Tensor data;  ///< Encoded data slice.
+        size_t encoding_row;  ///< Index of the first row of the data, @see encode_rows.
         size_t first_sample;       ///< Index of first raw data sample for the slice.
         size_t num_samples;        ///< Number of samples of raw data in the slice.
         size_t lead_samples_needed;  ///< Number of samples, if any, to pad the beginning of the raw data slice with.
@@ -59,8 +66,21 @@ public:
      *  positions is given by N = slice_blocks * block_stride. The context will be aligned so that sample N/2
      *  is the middle sample corresponding to the kmer in which the specified base is the primary base.
      *  The data is arranged in Feature-Time order i.e each column corresponds to the kmer at a given sample.
+     *  The data is a contiguous int8 tensor.
      */
     Context get_context(size_t seq_pos) const;
+
+    /// As get_context, but leaves the data empty so that no tensor is created.
+    Context get_context_bounds(size_t seq_pos) const;
+
+    /** Encode a window of rows of the padded encoding of the read, which covers every context.
+     *  @param first_row The first row to encode, as in Context::encoding_row.
+     *  @param num_rows The number of rows to encode.
+     *  @return A contiguous int8 tensor of [num_rows, kmer_len * 4].
+     *
+     *  Encoding the windows spanned by a run of contexts bounds the memory used for a long read.
+     */
+    torch::Tensor encode_rows(size_t first_row, size_t num_rows) const;
 };
 
 }  // namespace dorado
@@ -16,33 +16,28 @@ private:
     const size_t m_kmer_len;
     const size_t m_centre_index;
 
-    /** Get the index in the model kmer_levels corresponding to the input kmer
-     *  @param int_kmer_start Pointer to the start of the kmer in the sequence
-     *  @param kmer_len The length of the kmer
-     *  @return The index of the kmer
-     */
-    static inline size_t index_from_int_kmer(const int* int_kmer_start, size_t kmer_len);
+    // The number of bases at the start of a read the rescaling is calculated from.
+    static constexpr size_t kMaxBases = 1000;
 
     /** Get the expected normalized daq levels for in the input basecall sequence.
      *  @param int_seq The basecall sequence, encoded as integers with A=0, C=1, G=2, T=3
-     *  @return A vector of the expected normalized daq level for each base
+     *  @param max_bases The number of bases at the start of the sequence to get levels for
+     *  @return A vector of the expected normalized daq level for each of those bases
      */
-    std::vector<float> extract_levels(const std::vector<int>& int_seq) const;
+    std::vector<float> extract_levels(const std::vector<int>& int_seq, size_t max_bases) const;
 
     /** Calculate the new offset and scale 
      *  @param samples The normalized samples for the basecalled sequence
      *  @param seq_to_sig_map The indices of the samples corresponding to moves in the move table
-     *  @param levels The expected levels for each kmer in the basecalled sequence
+     *  @param levels The expected levels for each kmer of the bases to calculate the rescaling from
      *  @param clip_bases The number of bases to trim from the start and end of the sequence
-     *  @param max_bases is number of bases to calculate the rescaling from
      *
      *  @return The new offset and scale values
      */
     std::pair<float, float> calc_offset_scale(const torch::Tensor& samples,
                                               const std::vector<uint64_t>& seq_to_sig_map,
                                               const std::vector<float>& levels,
-                                              size_t clip_bases = 10,
-                                              size_t max_bases = 1000) const;
+                                              size_t clip_bases = 10) const;
 
 public:
     /**
@@ -50,11 +45,13 @@ public:
      * @param signal The signal for the basecalled sequence
      * @param seq_ints The basecall sequence, encoded as integers with A=0, C=1, G=2, T=3
      * @param seq_to_sig_map The indices of the samples corresponding to moves in the move table
-     * @return The rescaled input signal
+     * @param output_type The type of the rescaled signal, float16 or float32
+     * @return The rescaled input signal, contiguous and of output_type
     */
     torch::Tensor scale_signal(const torch::Tensor& signal,
                                const std::vector<int>& seq_ints,
-                               const std::vector<uint64_t>& seq_to_sig_map) const;
+                               const std::vector<uint64_t>& seq_to_sig_map,
+                               torch::ScalarType output_type = torch::kFloat16) const;
 
     /** Scale calculator for v1 Remora-style modified base detection.
      *  @param kmer_levels A vector of expected signal levels per kmer.
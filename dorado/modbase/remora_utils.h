@@ -15,19 +15,27 @@ public:
     static const std::vector<int> BASE_IDS;
 };
 
+// A context to be called, which refers to the signal of its read and a window of the read's
+// sequence encoding rather than owning copies of them.
 struct RemoraChunk {
     RemoraChunk(std::shared_ptr<Read> read,
-                torch::Tensor input_signal,
-                std::vector<int8_t> kmer_data,
+                torch::Tensor read_signal,
+                int64_t first_sample,
+                torch::Tensor encoding_window,
+                int64_t window_row,
                 size_t position)
             : source_read(read),
-              signal(input_signal),
-              encoded_kmers(std::move(kmer_data)),
+              signal(std::move(read_signal)),
+              encoded_kmers(std::move(encoding_window)),
+              signal_start(first_sample),
+              kmer_start(window_row),
               context_hit(position) {}
 
     std::weak_ptr<Read> source_read;
-    torch::Tensor signal;
-    std::vector<int8_t> encoded_kmers;
+    torch::Tensor signal;         // Scaled signal of the whole read.
+    torch::Tensor encoded_kmers;  // Kmer encoding of rows of the read, see RemoraEncoder.
+    int64_t signal_start;  // First sample of the context, negative if it starts before the signal.
+    int64_t kmer_start;    // First row of the context within encoded_kmers.
     size_t context_hit;
     std::vector<float> scores;
 };
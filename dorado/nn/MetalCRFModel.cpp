@@ -846,14 +846,19 @@ public:
             const int out_buf_idx = chunk_idx / m_out_batch_size;
             const int buf_chunk_idx = chunk_idx % m_out_batch_size;
 
-            auto [sequence, qstring, moves] = beam_search_decode(
+            // Qstrings are generated once chunks have been stitched.
+            auto [sequence, base_error_probs, moves] = beam_search_decode_error_probs(
                     m_scores_int8.at(out_buf_idx).index({Slice(), buf_chunk_idx}),
                     m_bwd.at(out_buf_idx)[buf_chunk_idx], m_posts.at(out_buf_idx)[buf_chunk_idx],
                     m_decoder_options.beam_width, m_decoder_options.beam_cut,
-                    m_decoder_options.blank_score, m_decoder_options.q_shift,
-                    m_decoder_options.q_scale, m_decoder_options.temperature, score_scale);
-
-            (*task->out_chunks)[chunk_idx] = DecodedChunk{sequence, qstring, moves};
+                    m_decoder_options.blank_score, m_decoder_options.temperature, score_scale);
+
+            auto &out_chunk = (*task->out_chunks)[chunk_idx];
+            out_chunk.sequence = std::move(sequence);
+            out_chunk.moves = std::move(moves);
+            out_chunk.base_error_probs = std::move(base_error_probs);
+            out_chunk.q_shift = m_decoder_options.q_shift;
+            out_chunk.q_scale = m_decoder_options.q_scale;
 
             // Wake the waiting thread which called `call_chunks()` if we're done decoding
             std::unique_lock<std::mutex> task_lock(task->mut);
@@ -17,7 +17,10 @@
 #include <toml.hpp>
 #include <torch/torch.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <future>
 
 using namespace std::chrono_literals;
 
@@ -78,10 +81,7 @@ public:
                 : input_sigs(input_sigs_), input_seqs(input_seqs_), num_chunks(num_chunks_) {}
         torch::Tensor input_sigs;
         torch::Tensor input_seqs;
-        std::mutex mut;
-        std::condition_variable cv;
-        torch::Tensor out;
-        bool done{false};
+        std::promise<torch::Tensor> out;
         int num_chunks;
     };
 
@@ -96,23 +96,6 @@ public:
         c10::optional<c10::Stream> stream;
 #endif
         int batch_size = 0;
-
-        std::vector<size_t> get_motif_hits(const std::string& seq) const {
-            NVTX3_FUNC_RANGE();
-            std::vector<size_t> context_hits;
-            const auto& motif = params.motif;
-            const auto motif_offset = params.motif_offset;
-            size_t kmer_len = motif.size();
-            size_t search_pos = 0;
-            while (search_pos < seq.size() - kmer_len + 1) {
-                search_pos = seq.find(motif, search_pos);
-                if (search_pos != std::string::npos) {
-                    context_hits.push_back(search_pos + motif_offset);
-                    ++search_pos;
-                }
-            }
-            return context_hits;
-        }
     };
 
     ModBaseCaller(const std::vector<std::filesystem::path>& model_paths,
@@ -200,10 +183,13 @@ public:
         }
     }
 
-    torch::Tensor call_chunks(size_t model_id,
-                              torch::Tensor& input_sigs,
-                              torch::Tensor& input_seqs,
-                              int num_chunks) {
+    // Queues the first num_chunks chunks of the inputs for the model, and returns a future for
+    // their scores.  On the CPU the inputs are used in place, so they must not be modified until
+    // the scores are ready.
+    std::future<torch::Tensor> submit_chunks(size_t model_id,
+                                             torch::Tensor& input_sigs,
+                                             torch::Tensor& input_seqs,
+                                             int num_chunks) {
         NVTX3_FUNC_RANGE();
         auto& caller_data = m_caller_data[model_id];
 
@@ -212,18 +198,13 @@ public:
 #endif
         auto task = std::make_shared<ModBaseTask>(input_sigs.to(m_options.device()),
                                                   input_seqs.to(m_options.device()), num_chunks);
+        auto scores = task->out.get_future();
         {
             std::lock_guard<std::mutex> lock(caller_data->input_lock);
             caller_data->input_queue.push_front(task);
         }
         caller_data->input_cv.notify_one();
-
-        std::unique_lock lock(task->mut);
-        while (!task->done) {
-            task->cv.wait(lock);
-        }
-
-        return task->out;
+        return scores;
     }
 
     void modbase_task_thread_fn(size_t model_id) {
@@ -248,25 +229,55 @@ public:
                 return;
             }
 
-            auto task = caller_data->input_queue.back();
+            // Partial batches queued by different runners are coalesced into one forward pass,
+            // as long as they fit into a single batch.
+            std::vector<std::shared_ptr<ModBaseTask>> tasks{caller_data->input_queue.back()};
             caller_data->input_queue.pop_back();
+            int num_chunks = tasks.front()->num_chunks;
+            while (!caller_data->input_queue.empty() &&
+                   num_chunks + caller_data->input_queue.back()->num_chunks <=
+                           caller_data->batch_size) {
+                tasks.push_back(caller_data->input_queue.back());
+                caller_data->input_queue.pop_back();
+                num_chunks += tasks.back()->num_chunks;
+            }
             input_lock.unlock();
 
-            std::unique_lock<std::mutex> task_lock(task->mut);
+            auto input_sigs = tasks.front()->input_sigs;
+            auto input_seqs = tasks.front()->input_seqs;
+            if (tasks.size() > 1) {
+                std::vector<torch::Tensor> sigs, seqs;
+                for (const auto& task : tasks) {
+                    sigs.push_back(task->input_sigs.narrow(0, 0, task->num_chunks));
+                    seqs.push_back(task->input_seqs.narrow(0, 0, task->num_chunks));
+                }
+                input_sigs = torch::cat(sigs);
+                input_seqs = torch::cat(seqs);
+                m_num_batches_coalesced += int64_t(tasks.size()) - 1;
+            }
+
             stats::Timer timer;
-            auto scores = caller_data->module_holder->forward(task->input_sigs, task->input_seqs);
-            task->out = scores.to(torch::kCPU);
+            try {
+                auto scores = caller_data->module_holder->forward(input_sigs, input_seqs)
+                                      .to(torch::kCPU);
 #if DORADO_GPU_BUILD && !defined(__APPLE__)
-            if (has_stream) {
-                caller_data->stream->synchronize();
-            }
-            // Only meaningful if we're syncing the stream.
-            m_model_ms += timer.GetElapsedMS();
+                if (has_stream) {
+                    caller_data->stream->synchronize();
+                }
+                // Only meaningful if we're syncing the stream.
+                m_model_ms += timer.GetElapsedMS();
 #endif
+                int64_t offset = 0;
+                for (auto& task : tasks) {
+                    task->out.set_value(scores.narrow(0, offset, task->num_chunks));
+                    offset += task->num_chunks;
+                }
+            } catch (...) {
+                for (auto& task : tasks) {
+                    task->out.set_exception(std::current_exception());
+                }
+            }
             ++m_num_batches_called;
-            task->done = true;
-            task_lock.unlock();
-            task->cv.notify_one();
         }
     }
 
@@ -295,6 +306,7 @@ public:
     stats::NamedStats sample_stats() const {
         stats::NamedStats stats;
         stats["batches_called"] = m_num_batches_called;
+        stats["batches_coalesced"] = m_num_batches_coalesced;
 #if DORADO_GPU_BUILD && !defined(__APPLE__)
         stats["model_ms"] = m_model_ms;
 #endif
@@ -310,6 +322,7 @@ public:
 
     // Performance monitoring stats.
     std::atomic<int64_t> m_num_batches_called = 0;
+    std::atomic<int64_t> m_num_batches_coalesced = 0;
     std::atomic<int64_t> m_model_ms = 0;
 };
 
@@ -335,57 +348,93 @@ ModBaseRunner::ModBaseRunner(std::shared_ptr<ModBaseCaller> caller) : m_caller(s
         auto sig_len = static_cast<int64_t>(caller_data->params.context_before +
                                             caller_data->params.context_after);
         auto kmer_len = caller_data->params.bases_after + caller_data->params.bases_before + 1;
-        m_input_sigs.push_back(torch::empty({caller_data->batch_size, 1, sig_len}, opts));
-        m_input_seqs.push_back(
-                torch::empty({caller_data->batch_size, sig_len, RemoraUtils::NUM_BASES * kmer_len},
-                             seq_input_options));
+        auto& buffers = m_inputs.emplace_back();
+        for (auto& buffer : buffers) {
+            buffer.sigs = torch::empty({caller_data->batch_size, 1, sig_len}, opts);
+            buffer.seqs = torch::empty(
+                    {caller_data->batch_size, sig_len, RemoraUtils::NUM_BASES * kmer_len},
+                    seq_input_options);
+        }
+        m_current_input.push_back(0);
     }
 }
 
-void ModBaseRunner::accept_chunk(int model_id,
-                                 int chunk_idx,
-                                 const torch::Tensor& signal,
-                                 const std::vector<int8_t>& kmers) {
+void ModBaseRunner::accept_chunk(int model_id, int chunk_idx, const RemoraChunk& chunk) {
     // As usual, avoid torch indexing because it is glacially slow.
     // GPU base calling uses float16 signals and input tensors.
     // CPU base calling uses float16 signals, float32 input tensors.
     // Both versions take int8 sequence encodings.
-
-    auto& input_sigs = m_input_sigs[model_id];
-    auto& input_seqs = m_input_seqs[model_id];
-    assert(signal.size(0) == input_sigs.size(2));
-
-    const auto sig_len = signal.size(0);
-    dorado::utils::copy_tensor_elems(input_sigs, chunk_idx * sig_len, signal, 0, sig_len);
+    // The chunk's signal and sequence encoding are copied straight from those of its read.
+
+    auto& input_sigs = m_inputs[model_id][m_current_input[model_id]].sigs;
+    auto& input_seqs = m_inputs[model_id][m_current_input[model_id]].seqs;
+
+    // Copy the part of the context which overlaps the signal, and zero pad the rest.
+    const int64_t sig_len = input_sigs.size(2);
+    const int64_t read_sig_len = chunk.signal.size(0);
+    const int64_t copy_start = std::max<int64_t>(chunk.signal_start, 0);
+    const int64_t copy_end = std::min(chunk.signal_start + sig_len, read_sig_len);
+    const int64_t lead = copy_start - chunk.signal_start;
+    const int64_t count = std::max<int64_t>(copy_end - copy_start, 0);
+    const size_t elem_size = input_sigs.element_size();
+    auto* const input_sigs_ptr =
+            reinterpret_cast<std::byte*>(input_sigs.data_ptr()) + chunk_idx * sig_len * elem_size;
+    std::memset(input_sigs_ptr, 0, lead * elem_size);
+    if (count > 0) {
+        dorado::utils::copy_tensor_elems(input_sigs, chunk_idx * sig_len + lead, chunk.signal,
+                                         copy_start, count);
+    }
+    std::memset(input_sigs_ptr + (lead + count) * elem_size, 0,
+                (sig_len - lead - count) * elem_size);
 
     const auto kmer_elem_count = input_seqs.size(1) * input_seqs.size(2);
     if (input_seqs.dtype() != torch::kInt8) {
         throw std::runtime_error("Unsupported input dtype");
     }
     using SeqInputType = int8_t;
+    assert(chunk.encoded_kmers.is_contiguous() &&
+           chunk.encoded_kmers.size(1) == input_seqs.size(2) &&
+           (chunk.kmer_start + input_seqs.size(1)) <= chunk.encoded_kmers.size(0));
     SeqInputType* const input_seqs_ptr = input_seqs.data_ptr<SeqInputType>();
-    std::memcpy(&input_seqs_ptr[chunk_idx * kmer_elem_count], kmers.data(),
+    const SeqInputType* const kmers_ptr =
+            chunk.encoded_kmers.data_ptr<SeqInputType>() + chunk.kmer_start * input_seqs.size(2);
+    std::memcpy(&input_seqs_ptr[chunk_idx * kmer_elem_count], kmers_ptr,
                 kmer_elem_count * sizeof(SeqInputType));
 }
 
+std::shared_future<torch::Tensor> ModBaseRunner::submit_chunks(int model_id, int num_chunks) {
+    auto& buffers = m_inputs[model_id];
+    auto& current = m_current_input[model_id];
+    buffers[current].result =
+            m_caller->submit_chunks(model_id, buffers[current].sigs, buffers[current].seqs,
+                                    num_chunks)
+                    .share();
+    auto result = buffers[current].result;
+
+    // Chunks for the next batch go into the other buffer, which must no longer be in use.
+    current ^= 1;
+    if (buffers[current].result.valid()) {
+        buffers[current].result.wait();
+        buffers[current].result = {};
+    }
+    return result;
+}
+
 torch::Tensor ModBaseRunner::call_chunks(int model_id, int num_chunks) {
-    return m_caller->call_chunks(model_id, m_input_sigs[model_id], m_input_seqs[model_id],
-                                 num_chunks);
+    return submit_chunks(model_id, num_chunks).get();
 }
 
 torch::Tensor ModBaseRunner::scale_signal(size_t caller_id,
                                           torch::Tensor signal,
                                           const std::vector<int>& seq_ints,
                                           const std::vector<uint64_t>& seq_to_sig_map) const {
+    // Converting once per read lets accept_chunk copy each chunk without conversion.
+    const auto input_type = m_inputs[caller_id][0].sigs.scalar_type();
     auto& scaler = m_caller->m_caller_data[caller_id]->scaler;
     if (scaler) {
-        return scaler->scale_signal(signal, seq_ints, seq_to_sig_map);
+        return scaler->scale_signal(signal, seq_ints, seq_to_sig_map, input_type);
     }
-    return signal;
-}
-
-std::vector<size_t> ModBaseRunner::get_motif_hits(size_t caller_id, const std::string& seq) const {
-    return m_caller->m_caller_data[caller_id]->get_motif_hits(seq);
+    return signal.to(input_type).contiguous();
 }
 
 ModBaseParams& ModBaseRunner::caller_params(size_t caller_id) const {
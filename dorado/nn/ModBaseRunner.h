@@ -4,14 +4,17 @@
 
 #include <torch/torch.h>
 
+#include <array>
 #include <atomic>
 #include <filesystem>
+#include <future>
 #include <string>
 #include <vector>
 
 namespace dorado {
 
 class ModBaseCaller;
+struct RemoraChunk;
 
 struct ModBaseParams {
     std::vector<std::string> mod_long_names;  ///< The long names of the modified bases.
@@ -40,19 +43,20 @@ std::shared_ptr<ModBaseCaller> create_modbase_caller(
 class ModBaseRunner {
 public:
     explicit ModBaseRunner(std::shared_ptr<ModBaseCaller> caller);
-    void accept_chunk(int model_id,
-                      int chunk_idx,
-                      const torch::Tensor& signal,
-                      const std::vector<int8_t>& kmers);
+    void accept_chunk(int model_id, int chunk_idx, const RemoraChunk& chunk);
+    // Queues the first num_chunks accepted chunks for the model and returns a future for their
+    // scores.  Accepting chunks for the next batch may overlap with this one being called, but
+    // submitting it waits for the scores of the batch before this one.
+    std::shared_future<torch::Tensor> submit_chunks(int model_id, int num_chunks);
     torch::Tensor call_chunks(int model_id, int num_chunks);
+    // Returns the scaled signal, contiguous and in the input type of the model.
     torch::Tensor scale_signal(size_t caller_id,
                                torch::Tensor signal,
                                const std::vector<int>& seq_ints,
                                const std::vector<uint64_t>& seq_to_sig_map) const;
-    std::vector<size_t> get_motif_hits(size_t caller_id, const std::string& seq) const;
     ModBaseParams& caller_params(size_t caller_id) const;
     size_t num_callers() const;
-    size_t batch_size() const { return m_input_sigs[0].size(0); }
+    size_t batch_size() const { return m_inputs[0][0].sigs.size(0); }
     void terminate();
     void restart();
     std::string get_name() const;
@@ -60,8 +64,15 @@ public:
 
 private:
     std::shared_ptr<ModBaseCaller> m_caller;
-    std::vector<torch::Tensor> m_input_sigs;
-    std::vector<torch::Tensor> m_input_seqs;
+    struct InputBuffers {
+        torch::Tensor sigs;
+        torch::Tensor seqs;
+        // Scores of the batch last submitted from these buffers.
+        std::shared_future<torch::Tensor> result;
+    };
+    // Each model's inputs are double buffered, so one batch can be filled while another is called.
+    std::vector<std::array<InputBuffers, 2>> m_inputs;
+    std::vector<int> m_current_input;
 
     // Performance monitoring stats.
     std::atomic<int64_t> m_num_batches_called = 0;
@@ -9,8 +9,12 @@
 #include <toml.hpp>
 #include <torch/torch.h>
 
+#include <algorithm>
 #include <atomic>
+#include <future>
+#include <iterator>
 #include <string>
+#include <vector>
 
 namespace dorado {
 
@@ -36,6 +40,16 @@ public:
                 const std::string &device,
                 int chunk_size,
                 int batch_size);
+    // Construct a runner around an already loaded module and decoder.  The module's weights
+    // (and the decoder's threads) are shared with any other runners constructed from them, so
+    // only the input buffer and activations are owned per runner.
+    ModelRunner(const CRFModelConfig &model_config,
+                torch::nn::ModuleHolder<torch::nn::AnyModule> module,
+                std::shared_ptr<T> decoder,
+                const std::string &device,
+                int chunk_size,
+                int batch_size,
+                DecodeStrategy decode_strategy = DecodeStrategy::BeamSearch);
     void accept_chunk(int chunk_idx, const torch::Tensor &chunk) final;
     std::vector<DecodedChunk> call_chunks(int num_chunks) final;
     size_t model_stride() const final { return m_model_stride; }
@@ -47,9 +61,12 @@ public:
     stats::NamedStats sample_stats() const final;
 
 private:
+    // Number of slices each batch is split into, so that decoding overlaps the forward pass.
+    static constexpr int kNumPipelineSlices = 4;
+
     torch::Tensor m_input;
     torch::TensorOptions m_options;
-    std::unique_ptr<T> m_decoder;
+    std::shared_ptr<T> m_decoder;
     DecoderOptions m_decoder_options;
     torch::nn::ModuleHolder<torch::nn::AnyModule> m_module{nullptr};
     size_t m_model_stride;
@@ -64,16 +81,32 @@ template <typename T>
 ModelRunner<T>::ModelRunner(const CRFModelConfig &model_config,
                             const std::string &device,
                             int chunk_size,
-                            int batch_size) {
+                            int batch_size)
+        : ModelRunner(model_config,
+                      load_crf_model(model_config,
+                                     torch::TensorOptions().dtype(T::dtype).device(device)),
+                      std::make_shared<T>(),
+                      device,
+                      chunk_size,
+                      batch_size) {}
+
+template <typename T>
+ModelRunner<T>::ModelRunner(const CRFModelConfig &model_config,
+                            torch::nn::ModuleHolder<torch::nn::AnyModule> module,
+                            std::shared_ptr<T> decoder,
+                            const std::string &device,
+                            int chunk_size,
+                            int batch_size,
+                            DecodeStrategy decode_strategy)
+        : m_decoder(std::move(decoder)), m_module(std::move(module)) {
     m_model_stride = static_cast<size_t>(model_config.stride);
 
     m_decoder_options = DecoderOptions();
+    m_decoder_options.strategy = decode_strategy;
     m_decoder_options.q_shift = model_config.qbias;
     m_decoder_options.q_scale = model_config.qscale;
-    m_decoder = std::make_unique<T>();
 
     m_options = torch::TensorOptions().dtype(T::dtype).device(device);
-    m_module = load_crf_model(model_config, m_options);
 
     // adjust chunk size to be a multiple of the stride
     chunk_size -= chunk_size % m_model_stride;
@@ -86,9 +119,36 @@ template <typename T>
 std::vector<DecodedChunk> ModelRunner<T>::call_chunks(int num_chunks) {
     torch::InferenceMode guard;
     dorado::stats::Timer timer;
-    auto scores = m_module->forward(m_input.to(m_options.device_opt().value()));
-    const auto forward_ms = timer.GetElapsedMS();
-    auto decoded_chunks = m_decoder->beam_search(scores, num_chunks, m_decoder_options);
+
+    // The batch is run through the model in slices, and each slice's chunks are queued for
+    // decoding as soon as its scores are ready, so that the decode of one slice overlaps the
+    // forward pass of the next.
+    std::vector<DecodedChunk> decoded_chunks(num_chunks);
+    std::vector<std::future<void>> decodes;
+    decodes.reserve(num_chunks);
+    const int slice_size = std::max(1, (num_chunks + kNumPipelineSlices - 1) / kNumPipelineSlices);
+    int64_t forward_ms = 0;
+    try {
+        for (int slice_start = 0; slice_start < num_chunks; slice_start += slice_size) {
+            const int slice_chunks = std::min(slice_size, num_chunks - slice_start);
+            const auto slice_timer_start_ms = timer.GetElapsedMS();
+            auto scores = m_module->forward(m_input.narrow(0, slice_start, slice_chunks)
+                                                    .to(m_options.device_opt().value()));
+            forward_ms += timer.GetElapsedMS() - slice_timer_start_ms;
+            auto slice_decodes = m_decoder->decode_async(scores, slice_chunks, m_decoder_options,
+                                                         decoded_chunks.data() + slice_start);
+            std::move(slice_decodes.begin(), slice_decodes.end(), std::back_inserter(decodes));
+        }
+    } catch (...) {
+        // The queued decodes write to decoded_chunks, so they must finish before it goes.
+        for (auto &decode : decodes) {
+            decode.wait();
+        }
+        throw;
+    }
+    T::wait_for_decodes(decodes);
+
+    // Decode time is the time spent on decoding that didn't overlap a forward pass.
     const auto forward_plus_decode_ms = timer.GetElapsedMS();
     ++m_num_batches_called;
     m_model_ms += forward_ms;
@@ -1,12 +1,19 @@
 #include "RemoraModel.h"
 
 #include "utils/module_utils.h"
+#include "utils/simd.h"
 #include "utils/tensor_utils.h"
 
 #include <toml.hpp>
 #include <torch/torch.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 using namespace torch::nn;
 using namespace torch::indexing;
@@ -46,6 +53,158 @@ struct UnpaddedConvolutionImpl : Module {
 
 TORCH_MODULE(UnpaddedConvolution);
 
+namespace {
+
+inline float silu(float x) { return x / (1.0f + std::exp(-x)); }
+
+// Computes a tile of kTileSteps consecutive outputs of kTileChannels channels of a convolution
+// followed by SiLU.  `input` points to the first input row under the first output, with
+// successive outputs `input_step` elements apart, and the window under each output is `n`
+// contiguous elements.  `weights` is [n][weight_stride], offset to the first channel of the tile.
+constexpr int kTileSteps = 4;
+constexpr int kTileChannels = 16;
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void conv_silu_tile(const float* input,
+                    int input_step,
+                    int n,
+                    const float* weights,
+                    int weight_stride,
+                    const float* biases,
+                    float* output,
+                    int output_stride) {
+    float acc[kTileSteps][kTileChannels];
+    for (int t = 0; t < kTileSteps; ++t) {
+        std::copy(biases, biases + kTileChannels, acc[t]);
+    }
+    for (int i = 0; i < n; ++i) {
+        const float* const w = weights + i * weight_stride;
+        for (int t = 0; t < kTileSteps; ++t) {
+            const float x = input[t * input_step + i];
+            for (int o = 0; o < kTileChannels; ++o) {
+                acc[t][o] += x * w[o];
+            }
+        }
+    }
+    for (int t = 0; t < kTileSteps; ++t) {
+        for (int o = 0; o < kTileChannels; ++o) {
+            output[t * output_stride + o] = silu(acc[t][o]);
+        }
+    }
+}
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("avx2"))) void conv_silu_tile(const float* input,
+                                                    int input_step,
+                                                    int n,
+                                                    const float* weights,
+                                                    int weight_stride,
+                                                    const float* biases,
+                                                    float* output,
+                                                    int output_stride) {
+    static_assert(kTileSteps == 4 && kTileChannels == 16);
+    // The tile's 64 accumulators live in 8 registers, so each weight row is loaded once per tile.
+    const __m256 bias_lo = _mm256_loadu_ps(biases);
+    const __m256 bias_hi = _mm256_loadu_ps(biases + 8);
+    __m256 acc_lo[kTileSteps] = {bias_lo, bias_lo, bias_lo, bias_lo};
+    __m256 acc_hi[kTileSteps] = {bias_hi, bias_hi, bias_hi, bias_hi};
+    for (int i = 0; i < n; ++i) {
+        const float* const w = weights + i * weight_stride;
+        const __m256 w_lo = _mm256_loadu_ps(w);
+        const __m256 w_hi = _mm256_loadu_ps(w + 8);
+        for (int t = 0; t < kTileSteps; ++t) {
+            const __m256 x = _mm256_broadcast_ss(input + t * input_step + i);
+            acc_lo[t] = _mm256_add_ps(acc_lo[t], _mm256_mul_ps(x, w_lo));
+            acc_hi[t] = _mm256_add_ps(acc_hi[t], _mm256_mul_ps(x, w_hi));
+        }
+    }
+    float acc[kTileChannels];
+    for (int t = 0; t < kTileSteps; ++t) {
+        _mm256_storeu_ps(acc, acc_lo[t]);
+        _mm256_storeu_ps(acc + 8, acc_hi[t]);
+        for (int o = 0; o < kTileChannels; ++o) {
+            output[t * output_stride + o] = silu(acc[o]);
+        }
+    }
+}
+#endif
+
+// Weights of an UnpaddedConvolution rearranged for the CPU kernels above, as
+// [kernel_size][in_channels][out_channels].  With activations stored as [time][channels], the
+// window under each output is then a contiguous run of kernel_size * in_channels inputs, and
+// the innermost loops run over contiguous output channels.
+struct PackedConvolution {
+    explicit PackedConvolution(const UnpaddedConvolution& layer) {
+        const auto& conv = layer->conv;
+        const auto weight = conv->weight.to(torch::kFloat32).permute({2, 1, 0}).contiguous();
+        const auto bias = conv->bias.to(torch::kFloat32).contiguous();
+        out_channels = int(weight.size(2));
+        in_channels = int(weight.size(1));
+        kernel_size = int(weight.size(0));
+        stride = int((*conv->options.stride())[0]);
+        weights.assign(weight.data_ptr<float>(), weight.data_ptr<float>() + weight.numel());
+        biases.assign(bias.data_ptr<float>(), bias.data_ptr<float>() + bias.numel());
+    }
+
+    int output_len(int input_len) const { return (input_len - kernel_size) / stride + 1; }
+
+    // Convolution followed by SiLU.  `input` is [input_len][in_channels].  Output rows are
+    // `output_stride` elements apart, so that outputs can be written side by side.
+    // For int8 input, which is one-hot and mostly zero, zero inputs are skipped so that each
+    // output accumulates only the weights of the bases present.
+    template <typename T>
+    void forward(const T* input, int input_len, float* output, int output_stride) const {
+        const int output_len = this->output_len(input_len);
+        const int window_size = kernel_size * in_channels;
+        const int input_step = stride * in_channels;
+
+        int t = 0;
+        if constexpr (std::is_same_v<T, float>) {
+            if (out_channels % kTileChannels == 0) {
+                for (; t + kTileSteps <= output_len; t += kTileSteps) {
+                    for (int o = 0; o < out_channels; o += kTileChannels) {
+                        conv_silu_tile(input + t * input_step, input_step, window_size,
+                                       &weights[o], out_channels, &biases[o],
+                                       output + t * output_stride + o, output_stride);
+                    }
+                }
+            }
+        }
+
+        for (; t < output_len; ++t) {
+            float* const out = output + t * output_stride;
+            std::copy(biases.begin(), biases.end(), out);
+            const T* const in = input + t * input_step;
+            for (int i = 0; i < window_size; ++i) {
+                if constexpr (std::is_same_v<T, int8_t>) {
+                    if (in[i] == 0) {
+                        continue;
+                    }
+                }
+                const float x = float(in[i]);
+                const float* const w = &weights[i * out_channels];
+                for (int o = 0; o < out_channels; ++o) {
+                    out[o] += x * w[o];
+                }
+            }
+            for (int o = 0; o < out_channels; ++o) {
+                out[o] = silu(out[o]);
+            }
+        }
+    }
+
+    int in_channels;
+    int out_channels;
+    int kernel_size;
+    int stride;
+    std::vector<float> weights;
+    std::vector<float> biases;
+};
+
+}  // namespace
+
 struct RemoraConvModelImpl : Module {
     RemoraConvModelImpl(int size, int kmer_len, int num_out) {
         sig_conv1 = register_module("sig_conv1", UnpaddedConvolution(1, 4, 11, 1));
@@ -65,6 +224,10 @@ struct RemoraConvModelImpl : Module {
     }
 
     torch::Tensor forward(torch::Tensor sigs, torch::Tensor seqs) {
+        if (sigs.device() == torch::kCPU && sigs.dtype() == torch::kFloat32) {
+            return forward_cpu(sigs, seqs);
+        }
+
         sigs = sig_conv1(sigs);
         sigs = sig_conv2(sigs);
         sigs = sig_conv3(sigs);
@@ -93,6 +256,119 @@ struct RemoraConvModelImpl : Module {
         return z;
     }
 
+    // The same computation as forward, for float32 inputs on the CPU, without the overhead of
+    // torch ops on these small shapes.  Activations are kept as [time][channels] per chunk, the
+    // int8 sequence input is consumed directly, and the concatenation is done by having the last
+    // signal and sequence convolutions write alternate halves of each row.
+    torch::Tensor forward_cpu(const torch::Tensor& sigs, const torch::Tensor& seqs) {
+        std::call_once(m_cpu_layers_packed, [this] { pack_cpu_layers(); });
+        const auto& sig1 = m_cpu_layers[0];
+        const auto& sig2 = m_cpu_layers[1];
+        const auto& sig3 = m_cpu_layers[2];
+        const auto& seq1 = m_cpu_layers[3];
+        const auto& seq2 = m_cpu_layers[4];
+        const auto& seq3 = m_cpu_layers[5];
+        const auto& merge1 = m_cpu_layers[6];
+        const auto& merge2 = m_cpu_layers[7];
+        const auto& merge3 = m_cpu_layers[8];
+        const auto& merge4 = m_cpu_layers[9];
+
+        const auto sigs_in = sigs.contiguous();
+        const auto seqs_in = seqs.to(torch::kInt8).contiguous();
+        const int batch_size = int(sigs_in.size(0));
+        const int input_len = int(sigs_in.size(2));
+        const int seq_channels = int(seqs_in.size(2));
+        if (seqs_in.size(1) != input_len || seq_channels != seq1.in_channels) {
+            throw std::runtime_error("Unexpected remora sequence input shape.");
+        }
+
+        const int size = merge1.out_channels;
+        const int sig1_len = sig1.output_len(input_len);
+        const int sig2_len = sig2.output_len(sig1_len);
+        const int seq1_len = seq1.output_len(input_len);
+        const int seq2_len = seq2.output_len(seq1_len);
+        const int merge_len = sig3.output_len(sig2_len);
+        const int merge1_len = merge1.output_len(merge_len);
+        const int merge2_len = merge2.output_len(merge1_len);
+        const int merge3_len = merge3.output_len(merge2_len);
+        const int final_len = merge4.output_len(merge3_len);
+        if (seq3.output_len(seq2_len) != merge_len || size * final_len != m_cpu_linear_in) {
+            throw std::runtime_error("Unexpected remora signal input length.");
+        }
+
+        // Scratch buffers, reused for each chunk.
+        int max_channels = 0;
+        for (const auto& layer : m_cpu_layers) {
+            max_channels = std::max(max_channels, layer.out_channels);
+        }
+        std::vector<float> buffer_a(size_t(input_len) * max_channels);
+        std::vector<float> buffer_b(buffer_a.size());
+        std::vector<float> merged(size_t(merge_len) * 2 * size);
+        std::vector<float> logits(m_cpu_linear_out);
+
+        auto output = torch::empty({batch_size, m_cpu_linear_out}, torch::kFloat32);
+        const float* const sigs_ptr = sigs_in.data_ptr<float>();
+        const int8_t* const seqs_ptr = seqs_in.data_ptr<int8_t>();
+        float* const output_ptr = output.data_ptr<float>();
+        for (int chunk = 0; chunk < batch_size; ++chunk) {
+            // The signal has a single channel, so [channel][time] is also [time][channel].
+            const float* const sig = sigs_ptr + size_t(chunk) * input_len;
+            sig1.forward(sig, input_len, buffer_a.data(), sig1.out_channels);
+            sig2.forward(buffer_a.data(), sig1_len, buffer_b.data(), sig2.out_channels);
+            sig3.forward(buffer_b.data(), sig2_len, merged.data(), 2 * size);
+
+            const int8_t* const seq = seqs_ptr + size_t(chunk) * input_len * seq_channels;
+            seq1.forward(seq, input_len, buffer_a.data(), seq1.out_channels);
+            seq2.forward(buffer_a.data(), seq1_len, buffer_b.data(), seq2.out_channels);
+            seq3.forward(buffer_b.data(), seq2_len, merged.data() + size, 2 * size);
+
+            merge1.forward(merged.data(), merge_len, buffer_a.data(), size);
+            merge2.forward(buffer_a.data(), merge1_len, buffer_b.data(), size);
+            merge3.forward(buffer_b.data(), merge2_len, buffer_a.data(), size);
+            merge4.forward(buffer_a.data(), merge3_len, buffer_b.data(), size);
+
+            // The linear layer expects the [channel][time] flattening of the final activations.
+            float max_logit = -std::numeric_limits<float>::infinity();
+            for (int o = 0; o < m_cpu_linear_out; ++o) {
+                const float* const w = &m_cpu_linear_weights[size_t(o) * m_cpu_linear_in];
+                float sum = m_cpu_linear_biases[o];
+                for (int c = 0; c < size; ++c) {
+                    for (int t = 0; t < final_len; ++t) {
+                        sum += w[c * final_len + t] * buffer_b[t * size + c];
+                    }
+                }
+                logits[o] = sum;
+                max_logit = std::max(max_logit, sum);
+            }
+
+            float* const out = output_ptr + size_t(chunk) * m_cpu_linear_out;
+            float total = 0.0f;
+            for (int o = 0; o < m_cpu_linear_out; ++o) {
+                out[o] = std::exp(logits[o] - max_logit);
+                total += out[o];
+            }
+            for (int o = 0; o < m_cpu_linear_out; ++o) {
+                out[o] /= total;
+            }
+        }
+        return output;
+    }
+
+    void pack_cpu_layers() {
+        for (const auto* layer : {&sig_conv1, &sig_conv2, &sig_conv3, &seq_conv1, &seq_conv2,
+                                  &seq_conv3, &merge_conv1, &merge_conv2, &merge_conv3,
+                                  &merge_conv4}) {
+            m_cpu_layers.emplace_back(*layer);
+        }
+        const auto weight = linear->weight.to(torch::kFloat32).contiguous();
+        const auto bias = linear->bias.to(torch::kFloat32).contiguous();
+        m_cpu_linear_out = int(weight.size(0));
+        m_cpu_linear_in = int(weight.size(1));
+        m_cpu_linear_weights.assign(weight.data_ptr<float>(),
+                                    weight.data_ptr<float>() + weight.numel());
+        m_cpu_linear_biases.assign(bias.data_ptr<float>(), bias.data_ptr<float>() + bias.numel());
+    }
+
     void load_state_dict(const std::vector<torch::Tensor>& weights) {
         utils::load_state_dict(*this, weights);
     }
@@ -114,6 +390,14 @@ struct RemoraConvModelImpl : Module {
     UnpaddedConvolution merge_conv3{nullptr};
     UnpaddedConvolution merge_conv4{nullptr};
     Linear linear{nullptr};
+
+    // Weights for forward_cpu, packed on first use.
+    std::once_flag m_cpu_layers_packed;
+    std::vector<PackedConvolution> m_cpu_layers;
+    std::vector<float> m_cpu_linear_weights;
+    std::vector<float> m_cpu_linear_biases;
+    int m_cpu_linear_in = 0;
+    int m_cpu_linear_out = 0;
 };
 
 const std::vector<std::string> RemoraConvModelImpl::weight_tensors{
@@ -26,9 +26,15 @@ std::pair<std::vector<dorado::Runner>, size_t> create_basecall_runners(
         size_t batch_size,
         size_t chunk_size,
         float memory_fraction,
-        bool guard_gpus) {
+        bool guard_gpus,
+        DecodeStrategy decode_strategy,
+        std::shared_ptr<CPUDecoder> cpu_decoder) {
     std::vector<dorado::Runner> runners;
 
+    if (decode_strategy != DecodeStrategy::BeamSearch && device != "cpu") {
+        throw std::runtime_error("Only beam search decoding is supported on device " + device);
+    }
+
     // Default is 1 device.  CUDA path may alter this.
     size_t num_devices = 1;
 
@@ -37,12 +43,21 @@ std::pair<std::vector<dorado::Runner>, size_t> create_basecall_runners(
         if (batch_size == 0) {
             batch_size = 128;
         }
+        if (!cpu_decoder) {
+            cpu_decoder = create_cpu_decoder(device, 0);
+        }
         spdlog::debug("- CPU calling: set batch size to {}, num_runners to {}", batch_size,
                       num_runners);
 
+        // Load the weights once and share them between all runners, rather than holding one
+        // copy per runner thread.  Likewise all runners submit chunks to one decode pool.
+        torch::InferenceMode guard;
+        auto module = load_crf_model(
+                model_config, torch::TensorOptions().dtype(CPUDecoder::dtype).device(device));
         for (size_t i = 0; i < num_runners; i++) {
             runners.push_back(std::make_shared<dorado::ModelRunner<dorado::CPUDecoder>>(
-                    model_config, device, chunk_size, batch_size));
+                    model_config, module, cpu_decoder, device, chunk_size, batch_size,
+                    decode_strategy));
         }
     }
 #if DORADO_GPU_BUILD
@@ -108,6 +123,18 @@ std::pair<std::vector<dorado::Runner>, size_t> create_basecall_runners(
     return {runners, num_devices};
 }
 
+std::shared_ptr<CPUDecoder> create_cpu_decoder(const std::string& device, size_t num_threads) {
+    if (device != "cpu") {
+        return nullptr;
+    }
+    // There is one CPU runner per hardware thread.
+    if (num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+    }
+    spdlog::debug("- CPU calling: set decode threads to {}", num_threads);
+    return std::make_shared<CPUDecoder>(num_threads);
+}
+
 std::vector<std::unique_ptr<dorado::ModBaseRunner>> create_modbase_runners(
         const std::string& remora_models,
         const std::string& device,
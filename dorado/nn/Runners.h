@@ -1,5 +1,7 @@
 #pragma once
 
+#include "decode/Decoder.h"
+
 #include <memory>
 #include <string>
 #include <utility>
@@ -8,6 +10,7 @@
 namespace dorado {
 
 struct CRFModelConfig;
+class CPUDecoder;
 class ModelRunnerBase;
 class ModBaseRunner;
 
@@ -20,7 +23,13 @@ std::pair<std::vector<dorado::Runner>, size_t> create_basecall_runners(
         size_t batch_size,
         size_t chunk_size,
         float memory_fraction = 1.f,
-        bool guard_gpus = false);
+        bool guard_gpus = false,
+        DecodeStrategy decode_strategy = DecodeStrategy::BeamSearch,
+        std::shared_ptr<CPUDecoder> cpu_decoder = nullptr);
+
+// Creates the decoder whose pool of `num_threads` threads is shared by the CPU runners of every
+// model, or one thread per CPU runner if 0.  Returns null for devices other than the CPU.
+std::shared_ptr<CPUDecoder> create_cpu_decoder(const std::string& device, size_t num_threads);
 
 std::vector<std::unique_ptr<dorado::ModBaseRunner>> create_modbase_runners(
         const std::string& remora_models,
@@ -1,33 +1,32 @@
 #include "BaseSpaceDuplexCallerNode.h"
 
-#include "3rdparty/edlib/edlib/include/edlib.h"
-#include "cxxpool.h"
+#include "htslib/sam.h"
 #include "utils/duplex_utils.h"
 #include "utils/sequence_utils.h"
 
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
-#include <chrono>
 #include <cstdint>
 #include <utility>
 #include <vector>
 
-using namespace std::chrono_literals;
 namespace {
 // Given two sequences, their quality scores, and alignments, computes a consensus sequence
-std::pair<std::vector<char>, std::vector<char>> compute_basespace_consensus(
+std::pair<std::string, std::string> compute_basespace_consensus(
         int alignment_start_position,
         int alignment_end_position,
-        std::vector<uint8_t> target_quality_scores,
+        const std::vector<uint8_t>& target_quality_scores,
         int target_cursor,
-        std::vector<uint8_t> query_quality_scores,
+        const std::vector<uint8_t>& query_quality_scores,
         int query_cursor,
         const std::string_view target_sequence,
         const std::string_view query_sequence,
         unsigned char* alignment) {
-    std::vector<char> consensus;
-    std::vector<char> quality_scores_phred;
+    std::string consensus;
+    std::string quality_scores_phred;
+    consensus.reserve(alignment_end_position - alignment_start_position);
+    quality_scores_phred.reserve(alignment_end_position - alignment_start_position);
 
     // Loop over each alignment position, within given alignment boundaries
     for (int i = alignment_start_position;
@@ -60,76 +59,144 @@ std::pair<std::vector<char>, std::vector<char>> compute_basespace_consensus(
             query_cursor++;
         }
     }
-    return std::make_pair(consensus, quality_scores_phred);
+    return std::make_pair(std::move(consensus), std::move(quality_scores_phred));
 }
+
+// Makes a read with the id, sequence and qstring of a BAM record.
+std::shared_ptr<dorado::Read> read_from_record(bam1_t* record) {
+    const uint32_t seqlen = record->core.l_qseq;
+    const uint8_t* const qualities = bam_get_qual(record);
+
+    auto read = std::make_shared<dorado::Read>();
+    read->read_id = bam_get_qname(record);
+    read->seq = dorado::utils::convert_nt16_to_str(bam_get_seq(record), seqlen);
+    read->qstring.resize(seqlen);
+    std::transform(qualities, qualities + seqlen, read->qstring.begin(),
+                   [](uint8_t qual) { return char(qual + 33); });
+    return read;
+}
+
 }  // namespace
 
 namespace dorado {
 
 void BaseSpaceDuplexCallerNode::worker_thread() {
-    cxxpool::thread_pool pool{m_num_worker_threads};
-    std::vector<std::future<void>> futures;
+    // The caller must hold m_read_cache_mutex.
+    const auto is_paired = [this](const std::string& read_id) {
+        return m_template_complement_map.count(read_id) != 0 ||
+               m_complement_template_map.count(read_id) != 0;
+    };
+    const auto locked_is_paired = [&](const std::string& read_id) {
+        std::lock_guard<std::mutex> lock(m_read_cache_mutex);
+        return is_paired(read_id);
+    };
+
+    Message message;
+    while (get_input_message(message)) {
+        std::shared_ptr<Read> read;
+        if (std::holds_alternative<BamPtr>(message)) {
+            auto& record = std::get<BamPtr>(message);
+            // Records which aren't part of a pair are dropped without being converted.
+            if (!locked_is_paired(bam_get_qname(record.get()))) {
+                continue;
+            }
+            read = read_from_record(record.get());
+        } else if (std::holds_alternative<std::shared_ptr<Read>>(message)) {
+            read = std::get<std::shared_ptr<Read>>(std::move(message));
+            if (!locked_is_paired(read->read_id)) {
+                continue;
+            }
+        } else {
+            send_message_to_sink(std::move(message));
+            continue;
+        }
 
-    for (auto key : m_template_complement_map) {
-        futures.push_back(pool.push([key, this] { return basespace(key.first, key.second); }));
-    }
-    for (auto& v : futures) {
-        v.get();
-    }
-}
+        // Pair the read with any partners which have already arrived.  A partner is evicted from
+        // the cache once it has been paired with all of its partners, and the read is cached
+        // until the same is true of it.  Each pair is erased from the pair maps once it has been
+        // called, so nothing is held for reads which have been dealt with.
+        std::vector<std::pair<std::shared_ptr<Read>, std::shared_ptr<Read>>> ready_pairs;
+        {
+            std::lock_guard<std::mutex> lock(m_read_cache_mutex);
+            // Only the first record of a read is used, as a BAM may hold several records with
+            // the same read id, which would otherwise be paired again.  A repeated record either
+            // finds the first one still cached, or finds its pairs already called.
+            if (!is_paired(read->read_id) || m_read_cache.count(read->read_id) != 0) {
+                spdlog::debug("Ignoring repeated record of read ID={}", read->read_id);
+                continue;
+            }
 
-void BaseSpaceDuplexCallerNode::basespace(const std::string& template_read_id,
-                                          const std::string& complement_read_id) {
-    EdlibAlignConfig align_config = edlibDefaultAlignConfig();
-    align_config.task = EDLIB_TASK_PATH;
-
-    std::string_view template_sequence;
-    std::shared_ptr<Read> template_read;
-    std::vector<uint8_t> template_quality_scores;
-    auto template_read_it = m_reads.find(template_read_id);
-    if (template_read_it == m_reads.end()) {
-        spdlog::debug("Template Read ID={} is present in pairs file but read was not found",
-                      template_read_id);
-        return;
-    } else {
-        template_read = template_read_it->second;
-        template_sequence = template_read->seq;
-        template_quality_scores =
-                std::vector<uint8_t>(template_read->qstring.begin(), template_read->qstring.end());
-    }
+            int unpaired_partners = 0;
+            const auto take_partner = [&](const std::string& partner_id) {
+                auto partner_it = m_read_cache.find(partner_id);
+                if (partner_it == m_read_cache.end()) {
+                    ++unpaired_partners;
+                    return std::shared_ptr<Read>();
+                }
+                auto partner = partner_it->second.read;
+                if (--partner_it->second.unpaired_partners == 0) {
+                    m_read_cache.erase(partner_it);
+                }
+                return partner;
+            };
+
+            auto tc_it = m_template_complement_map.find(read->read_id);
+            if (tc_it != m_template_complement_map.end()) {
+                if (auto complement_read = take_partner(tc_it->second)) {
+                    m_complement_template_map.erase(tc_it->second);
+                    m_template_complement_map.erase(tc_it);
+                    ready_pairs.emplace_back(read, std::move(complement_read));
+                }
+            }
+            auto ct_it = m_complement_template_map.find(read->read_id);
+            if (ct_it != m_complement_template_map.end()) {
+                if (auto template_read = take_partner(ct_it->second)) {
+                    m_template_complement_map.erase(ct_it->second);
+                    m_complement_template_map.erase(ct_it);
+                    ready_pairs.emplace_back(std::move(template_read), read);
+                }
+            }
+            if (unpaired_partners > 0) {
+                m_read_cache[read->read_id] = {read, unpaired_partners};
+            }
+        }
 
-    // For basespace, a q score filter is run over the quality scores.
-    utils::preprocess_quality_scores(template_quality_scores);
+        for (const auto& [template_read, complement_read] : ready_pairs) {
+            basespace(*template_read, *complement_read);
+        }
+    }
 
-    auto complement_read_it = m_reads.find(complement_read_id);
-    if (complement_read_it == m_reads.end()) {
-        spdlog::debug("Complement ID={} paired with Template ID={} was not found",
-                      complement_read_id, template_read_id);
-        return;
+    if (--m_num_active_worker_threads == 0) {
+        // Last thread alive reports and clears the reads whose partners never arrived.
+        std::lock_guard<std::mutex> lock(m_read_cache_mutex);
+        for (const auto& [read_id, cached_read] : m_read_cache) {
+            spdlog::debug("Read ID={} is present in pairs file but its partner was not found",
+                          read_id);
+        }
+        m_read_cache.clear();
     }
+}
 
+void BaseSpaceDuplexCallerNode::basespace(const Read& template_read,
+                                          const Read& complement_read) {
+    const std::string_view template_sequence = template_read.seq;
     if (template_sequence.empty()) {
         return;
     }
 
-    // We have both sequences and can perform the consensus
-    auto complement_read = complement_read_it->second;
-    auto complement_quality_scores_reverse =
-            std::vector<uint8_t>(complement_read->qstring.begin(), complement_read->qstring.end());
-    std::reverse(complement_quality_scores_reverse.begin(),
-                 complement_quality_scores_reverse.end());
-
     // For basespace, a q score filter is run over the quality scores.
-    utils::preprocess_quality_scores(complement_quality_scores_reverse);
+    const auto template_quality_scores = utils::preprocess_quality_scores(template_read.qstring);
+    const auto complement_quality_scores_reverse =
+            utils::preprocess_quality_scores(complement_read.qstring, true);
 
     // Compute the RC
     auto complement_sequence_reverse_complement =
-            dorado::utils::reverse_complement(complement_read->seq);
+            dorado::utils::reverse_complement(complement_read.seq);
 
-    EdlibAlignResult result =
-            edlibAlign(template_sequence.data(), template_sequence.size(),
-                       complement_sequence_reverse_complement.data(),
-                       complement_sequence_reverse_complement.size(), align_config);
+    EdlibAlignResult result = utils::align_duplex_strands(
+            template_sequence.data(), template_sequence.size(),
+            complement_sequence_reverse_complement.data(),
+            complement_sequence_reverse_complement.size());
 
     // Now - we have to do the actual basespace alignment itself
     int query_cursor = 0;
@@ -166,12 +233,11 @@ void BaseSpaceDuplexCallerNode::basespace(const std::string& template_read_id,
 
         auto duplex_read = std::make_shared<Read>();
         duplex_read->is_duplex = true;
-        duplex_read->seq = std::string(consensus.begin(), consensus.end());
-        duplex_read->qstring =
-                std::string(quality_scores_phred.begin(), quality_scores_phred.end());
+        duplex_read->seq = std::move(consensus);
+        duplex_read->qstring = std::move(quality_scores_phred);
 
-        duplex_read->read_id = template_read->read_id + ";" + complement_read->read_id;
-        duplex_read->read_tag = template_read->read_tag;
+        duplex_read->read_id = template_read.read_id + ";" + complement_read.read_id;
+        duplex_read->read_tag = template_read.read_tag;
 
         send_message_to_sink(duplex_read);
     }
@@ -180,26 +246,32 @@ void BaseSpaceDuplexCallerNode::basespace(const std::string& template_read_id,
 
 BaseSpaceDuplexCallerNode::BaseSpaceDuplexCallerNode(
         std::map<std::string, std::string> template_complement_map,
-        read_map reads,
         size_t threads)
         : MessageSink(1000),
-          m_template_complement_map(std::move(template_complement_map)),
-          m_reads(std::move(reads)),
-          m_num_worker_threads(threads) {
+          m_num_worker_threads(threads),
+          m_template_complement_map(std::move(template_complement_map)) {
+    for (const auto& [template_id, complement_id] : m_template_complement_map) {
+        m_complement_template_map[complement_id] = template_id;
+    }
     start_threads();
 }
 
 void BaseSpaceDuplexCallerNode::start_threads() {
-    m_worker_thread =
-            std::make_unique<std::thread>(&BaseSpaceDuplexCallerNode::worker_thread, this);
+    for (size_t i = 0; i < m_num_worker_threads; ++i) {
+        m_worker_threads.push_back(
+                std::make_unique<std::thread>(&BaseSpaceDuplexCallerNode::worker_thread, this));
+        ++m_num_active_worker_threads;
+    }
 }
 
 void BaseSpaceDuplexCallerNode::terminate_impl() {
     terminate_input_queue();
-    if (m_worker_thread && m_worker_thread->joinable()) {
-        m_worker_thread->join();
+    for (auto& t : m_worker_threads) {
+        if (t->joinable()) {
+            t->join();
+        }
     }
-    m_worker_thread.reset();
+    m_worker_threads.clear();
 }
 
 void BaseSpaceDuplexCallerNode::restart() {
@@ -1,20 +1,24 @@
 #pragma once
-#include "HtsReader.h"
 #include "ReadPipeline.h"
-#include "utils/bam_utils.h"
 
+#include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace dorado {
 // Duplex caller node receives a map of template_id to complement_id (typically generated from a pairs file),
-// and a map of `read_id` to `dorado::Read` object. It then performs duplex calling and pushes `dorado::Read`
-// objects to its output queue.
+// and consumes `dorado::Read` objects or BAM records. As soon as both reads of a pair have arrived
+// it performs duplex calling and pushes a `dorado::Read` object to its output queue. Reads are only
+// held until all the pairs they belong to have been called, so the input can be streamed from a
+// BAM of any size.
 class BaseSpaceDuplexCallerNode : public MessageSink {
 public:
     BaseSpaceDuplexCallerNode(std::map<std::string, std::string> template_complement_map,
-                              read_map reads,
                               size_t threads);
     ~BaseSpaceDuplexCallerNode() { terminate_impl(); }
     std::string get_name() const override { return "BaseSpaceDuplexCallerNode"; }
@@ -22,14 +26,25 @@ public:
     void restart() override;
 
 private:
+    // A read waiting for the partners of the pairs it belongs to.
+    struct CachedRead {
+        std::shared_ptr<Read> read;
+        int unpaired_partners;
+    };
+
     void start_threads();
     void terminate_impl();
     void worker_thread();
-    void basespace(const std::string& template_read_id, const std::string& complement_read_id);
+    void basespace(const Read& template_read, const Read& complement_read);
 
     size_t m_num_worker_threads{1};
-    std::unique_ptr<std::thread> m_worker_thread;
+    std::vector<std::unique_ptr<std::thread>> m_worker_threads;
+    std::atomic<size_t> m_num_active_worker_threads{0};
+    // Also guards the pair maps, whose pairs are erased once they have been called, so that
+    // repeated records of their reads are ignored.
+    std::mutex m_read_cache_mutex;
     std::map<std::string, std::string> m_template_complement_map;
-    read_map m_reads;
+    std::map<std::string, std::string> m_complement_template_map;
+    std::unordered_map<std::string, CachedRead> m_read_cache;
 };
 }  // namespace dorado
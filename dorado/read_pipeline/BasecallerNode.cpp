@@ -95,9 +95,22 @@ void BasecallerNode::basecall_current_batch(int worker_id) {
     m_call_chunks_ms += timer.GetElapsedMS();
 
     for (size_t i = 0; i < m_batched_chunks[worker_id].size(); i++) {
-        m_batched_chunks[worker_id][i]->seq = decode_results[i].sequence;
-        m_batched_chunks[worker_id][i]->qstring = decode_results[i].qstring;
-        m_batched_chunks[worker_id][i]->moves = decode_results[i].moves;
+        auto &chunk = m_batched_chunks[worker_id][i];
+        auto &decode_result = decode_results[i];
+        chunk->seq = std::move(decode_result.sequence);
+        chunk->qstring = std::move(decode_result.qstring);
+        chunk->moves = std::move(decode_result.moves);
+        chunk->base_error_probs = std::move(decode_result.base_error_probs);
+        chunk->q_shift = decode_result.q_shift;
+        chunk->q_scale = decode_result.q_scale;
+    }
+
+    if (m_chunk_cache) {
+        auto &keys = m_batched_chunk_keys[worker_id];
+        for (size_t i = 0; i < keys.size(); i++) {
+            m_chunk_cache->store(keys[i], *m_batched_chunks[worker_id][i]);
+        }
+        keys.clear();
     }
 
     for (auto &complete_chunk : m_batched_chunks[worker_id]) {
@@ -205,6 +218,18 @@ void BasecallerNode::basecall_worker_thread(int worker_id) {
                 }
             }
 
+            // Chunks already in the cache skip the batch and go straight to stitching.
+            if (m_chunk_cache) {
+                const auto key = m_chunk_cache->key(input_slice);
+                if (m_chunk_cache->load(key, *chunk)) {
+                    ++m_num_chunk_cache_hits;
+                    m_processed_chunks.try_push(std::move(chunk));
+                    last_chunk_reserve_time = std::chrono::system_clock::now();
+                    continue;
+                }
+                m_batched_chunk_keys[worker_id].push_back(key);
+            }
+
             // Insert the chunk in the input tensor
             m_model_runners[worker_id]->accept_chunk(
                     static_cast<int>(m_batched_chunks[worker_id].size()), input_slice);
@@ -260,7 +285,8 @@ BasecallerNode::BasecallerNode(std::vector<Runner> model_runners,
                                size_t max_reads,
                                const std::string &node_name,
                                bool in_duplex_pipeline,
-                               uint32_t read_mean_qscore_start_pos)
+                               uint32_t read_mean_qscore_start_pos,
+                               std::shared_ptr<const utils::ChunkCache> chunk_cache)
         : MessageSink(max_reads),
           m_model_runners(std::move(model_runners)),
           m_chunk_size(m_model_runners.front()->chunk_size()),
@@ -271,12 +297,14 @@ BasecallerNode::BasecallerNode(std::vector<Runner> model_runners,
           m_max_reads(max_reads),
           m_in_duplex_pipeline(in_duplex_pipeline),
           m_mean_qscore_start_pos(read_mean_qscore_start_pos),
+          m_chunk_cache(std::move(chunk_cache)),
           m_chunks_in(CalcMaxChunksIn(m_model_runners)),
           m_processed_chunks(CalcMaxChunksIn(m_model_runners)),
           m_node_name(node_name) {
     // Setup worker state
     const size_t num_workers = m_model_runners.size();
     m_batched_chunks.resize(num_workers);
+    m_batched_chunk_keys.resize(num_workers);
 
     initialization_time = std::chrono::system_clock::now();
 
@@ -338,6 +366,7 @@ stats::NamedStats BasecallerNode::sample_stats() const {
     stats["batches_called"] = m_num_batches_called;
     stats["partial_batches_called"] = m_num_partial_batches_called;
     stats["call_chunks_ms"] = m_call_chunks_ms;
+    stats["chunk_cache_hits"] = m_num_chunk_cache_hits;
     stats["called_reads_pushed"] = m_called_reads_pushed;
     stats["working_reads_items"] = m_working_reads_size;
     stats["bases_processed"] = m_num_bases_processed;
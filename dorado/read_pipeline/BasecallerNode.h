@@ -3,6 +3,7 @@
 #include "../nn/ModelRunner.h"
 #include "ReadPipeline.h"
 #include "utils/AsyncQueue.h"
+#include "utils/chunk_cache.h"
 #include "utils/stats.h"
 
 #include <atomic>
@@ -21,7 +22,8 @@ public:
                    size_t max_reads = 1000,
                    const std::string& node_name = "BasecallerNode",
                    bool in_duplex_pipeline = false,
-                   uint32_t read_mean_qscore_start_pos = 0);
+                   uint32_t read_mean_qscore_start_pos = 0,
+                   std::shared_ptr<const utils::ChunkCache> chunk_cache = nullptr);
     ~BasecallerNode() { terminate_impl(); }
     std::string get_name() const override { return m_node_name; }
     stats::NamedStats sample_stats() const override;
@@ -58,6 +60,8 @@ private:
     bool m_in_duplex_pipeline;
     // Mean Q-score start position from model properties.
     uint32_t m_mean_qscore_start_pos;
+    // Optional cache of decoded chunks, consulted before chunks are batched.
+    std::shared_ptr<const utils::ChunkCache> m_chunk_cache;
 
     // Model runners which have not terminated.
     std::atomic<int> m_num_active_model_runners{0};
@@ -75,6 +79,8 @@ private:
 
     // If we go multi-threaded, there will be one of these batches per thread
     std::vector<std::deque<std::shared_ptr<Chunk>>> m_batched_chunks;
+    // Cache keys of the batched chunks, if there is a chunk cache.
+    std::vector<std::vector<utils::ChunkCache::Key>> m_batched_chunk_keys;
 
     utils::AsyncQueue<std::shared_ptr<Chunk>> m_processed_chunks;
 
@@ -98,6 +104,7 @@ private:
     std::atomic<int64_t> m_working_reads_size = 0;
     std::atomic<int64_t> m_num_bases_processed = 0;
     std::atomic<int64_t> m_num_samples_processed = 0;
+    std::atomic<int64_t> m_num_chunk_cache_hits = 0;
 };
 
 }  // namespace dorado
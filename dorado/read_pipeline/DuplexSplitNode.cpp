@@ -4,6 +4,7 @@
 #include "utils/duplex_utils.h"
 #include "utils/read_utils.h"
 #include "utils/sequence_utils.h"
+#include "utils/simd.h"
 #include "utils/time_utils.h"
 #include "utils/uuid_utils.h"
 
@@ -44,76 +45,145 @@ PosRanges merge_ranges(const PosRanges& ranges, uint64_t merge_dist) {
     return merged;
 }
 
-std::vector<std::pair<uint64_t, uint64_t>> detect_pore_signal(const torch::Tensor& signal,
+//index of the first sample at or after start which is above threshold, or size if there is none
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+uint64_t next_sample_above(const c10::Half* const signal,
+                           uint64_t size,
+                           uint64_t start,
+                           float threshold) {
+    for (auto i = start; i < size; i++) {
+        if (static_cast<float>(signal[i]) > threshold) {
+            return i;
+        }
+    }
+    return size;
+}
+
+#if ENABLE_AVX2_IMPL
+// f16c provides the float16 conversions.
+__attribute__((target("avx2,f16c"))) uint64_t next_sample_above(const c10::Half* const signal,
+                                                                uint64_t size,
+                                                                uint64_t start,
+                                                                float threshold) {
+    const __m256 threshold_vec = _mm256_set1_ps(threshold);
+
+    // Main vectorised loop: 8 samples per iteration.  Open pore samples are rare, so the lanes
+    // are only examined once a block contains one.
+    auto i = start;
+    for (; i + 8 <= size; i += 8) {
+        const __m128i elems_f16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(signal + i));
+        const __m256 above = _mm256_cmp_ps(_mm256_cvtph_ps(elems_f16), threshold_vec, _CMP_GT_OQ);
+        const int above_mask = _mm256_movemask_ps(above);
+        if (above_mask != 0) {
+            int lane = 0;
+            while (!((above_mask >> lane) & 1)) {
+                lane++;
+            }
+            return i + lane;
+        }
+    }
+
+    // Loop for final 0-7 samples.
+    for (; i < size; i++) {
+        if (static_cast<float>(signal[i]) > threshold) {
+            return i;
+        }
+    }
+    return size;
+}
+#endif
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+uint64_t next_sample_above(const float* const signal,
+                           uint64_t size,
+                           uint64_t start,
+                           float threshold) {
+    for (auto i = start; i < size; i++) {
+        if (signal[i] > threshold) {
+            return i;
+        }
+    }
+    return size;
+}
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("avx2"))) uint64_t next_sample_above(const float* const signal,
+                                                           uint64_t size,
+                                                           uint64_t start,
+                                                           float threshold) {
+    const __m256 threshold_vec = _mm256_set1_ps(threshold);
+
+    // As for float16, 8 samples per iteration, only examining the lanes of blocks with a hit.
+    auto i = start;
+    for (; i + 8 <= size; i += 8) {
+        const __m256 above = _mm256_cmp_ps(_mm256_loadu_ps(signal + i), threshold_vec, _CMP_GT_OQ);
+        const int above_mask = _mm256_movemask_ps(above);
+        if (above_mask != 0) {
+            int lane = 0;
+            while (!((above_mask >> lane) & 1)) {
+                lane++;
+            }
+            return i + lane;
+        }
+    }
+
+    // Loop for final 0-7 samples.
+    for (; i < size; i++) {
+        if (signal[i] > threshold) {
+            return i;
+        }
+    }
+    return size;
+}
+#endif
+
+//samples are float16 or float32, and are compared with the threshold as they are
+template <typename T>
+std::vector<std::pair<uint64_t, uint64_t>> detect_pore_signal(const T* const samples,
+                                                              uint64_t size,
                                                               float threshold,
                                                               uint64_t cluster_dist,
                                                               uint64_t ignore_prefix) {
     std::vector<std::pair<uint64_t, uint64_t>> ans;
-    auto pore_a = signal.accessor<float, 1>();
     int64_t cl_start = -1;
     int64_t cl_end = -1;
 
-    for (auto i = ignore_prefix; i < pore_a.size(0); i++) {
-        if (pore_a[i] > threshold) {
-            //check if we need to start new cluster
-            if (cl_end == -1 || i > cl_end + cluster_dist) {
-                //report previous cluster
-                if (cl_end != -1) {
-                    assert(cl_start != -1);
-                    ans.push_back({cl_start, cl_end});
-                }
-                cl_start = i;
+    for (auto i = next_sample_above(samples, size, ignore_prefix, threshold); i < size;
+         i = next_sample_above(samples, size, i + 1, threshold)) {
+        //check if we need to start new cluster
+        if (cl_end == -1 || i > cl_end + cluster_dist) {
+            //report previous cluster
+            if (cl_end != -1) {
+                assert(cl_start != -1);
+                ans.push_back({cl_start, cl_end});
             }
-            cl_end = i + 1;
+            cl_start = i;
         }
+        cl_end = i + 1;
     }
     //report last cluster
     if (cl_end != -1) {
         assert(cl_start != -1);
-        assert(cl_start < pore_a.size(0) && cl_end <= pore_a.size(0));
+        assert(cl_start < size && cl_end <= size);
         ans.push_back(std::pair{cl_start, cl_end});
     }
 
     return ans;
 }
 
-//[start, end)
-std::optional<PosRange> find_best_adapter_match(const std::string& adapter,
-                                                const std::string& seq,
-                                                int dist_thr,
-                                                PosRange subrange) {
-    assert(subrange.first <= subrange.second && subrange.second <= seq.size());
-    auto shift = subrange.first;
-    auto span = subrange.second - subrange.first;
-
-    if (span == 0)
-        return std::nullopt;
-
-    auto edlib_cfg = edlibNewAlignConfig(dist_thr, EDLIB_MODE_HW, EDLIB_TASK_LOC, NULL, 0);
-
-    auto edlib_result =
-            edlibAlign(adapter.c_str(), adapter.size(), seq.c_str() + shift, span, edlib_cfg);
-    assert(edlib_result.status == EDLIB_STATUS_OK);
-    std::optional<PosRange> res = std::nullopt;
-    if (edlib_result.status == EDLIB_STATUS_OK && edlib_result.editDistance != -1) {
-        assert(edlib_result.editDistance <= dist_thr);
-        res = {edlib_result.startLocations[0] + shift, edlib_result.endLocations[0] + shift + 1};
-    }
-    edlibFreeAlignResult(edlib_result);
-    return res;
-}
-
-//currently just finds a single best match
-//TODO efficiently find more matches
-std::vector<PosRange> find_adapter_matches(const std::string& adapter,
-                                           const std::string& seq,
+//all matches outside of the ignored prefix
+std::vector<PosRange> find_adapter_matches(const utils::AdapterIndex& adapter_index,
+                                           uint64_t seq_size,
                                            int dist_thr,
                                            uint64_t ignore_prefix) {
     std::vector<PosRange> answer;
-    if (ignore_prefix < seq.size()) {
-        if (auto best_match =
-                    find_best_adapter_match(adapter, seq, dist_thr, {ignore_prefix, seq.size()})) {
-            answer.push_back(*best_match);
+    if (ignore_prefix < seq_size) {
+        for (const auto& match : adapter_index.matches({ignore_prefix, seq_size}, dist_thr)) {
+            answer.push_back(match.range);
         }
     }
     return answer;
@@ -213,17 +283,31 @@ DuplexSplitNode::ExtRead DuplexSplitNode::create_ext_read(std::shared_ptr<Read>
     ext_read.move_sums = utils::move_cum_sums(r->moves);
     assert(!ext_read.move_sums.empty());
     assert(ext_read.move_sums.back() == r->seq.length());
-    ext_read.data_as_float32 = r->raw_data.to(torch::kFloat);
     ext_read.possible_pore_regions = possible_pore_regions(ext_read);
+    //adapters are searched for at both the strict and the relaxed edit distance
+    ext_read.adapter_index = utils::AdapterIndex(
+            m_settings.adapter, r->seq,
+            std::max(m_settings.adapter_edist, m_settings.relaxed_adapter_edist));
     return ext_read;
 }
 
 PosRanges DuplexSplitNode::possible_pore_regions(const DuplexSplitNode::ExtRead& read) const {
     spdlog::trace("Analyzing signal in read {}", read.read->read_id);
 
-    auto pore_sample_ranges =
-            detect_pore_signal(read.data_as_float32, m_settings.pore_thr, m_settings.pore_cl_dist,
-                               m_settings.expect_pore_prefix);
+    // Float16 and float32 signals are scanned in place.  Any other type is widened to float32
+    // rather than narrowed, so that no sample is rounded across the threshold.
+    const auto& raw_data = read.read->raw_data;
+    std::vector<std::pair<uint64_t, uint64_t>> pore_sample_ranges;
+    if (raw_data.dtype() == torch::kFloat16) {
+        pore_sample_ranges = detect_pore_signal(raw_data.data_ptr<c10::Half>(), raw_data.size(0),
+                                                m_settings.pore_thr, m_settings.pore_cl_dist,
+                                                m_settings.expect_pore_prefix);
+    } else {
+        const auto signal = raw_data.to(torch::kFloat32);
+        pore_sample_ranges = detect_pore_signal(signal.data_ptr<float>(), signal.size(0),
+                                                m_settings.pore_thr, m_settings.pore_cl_dist,
+                                                m_settings.expect_pore_prefix);
+    }
 
     PosRanges pore_regions;
     for (auto pore_sample_range : pore_sample_ranges) {
@@ -248,12 +332,13 @@ PosRanges DuplexSplitNode::possible_pore_regions(const DuplexSplitNode::ExtRead&
     return pore_regions;
 }
 
-bool DuplexSplitNode::check_nearby_adapter(const Read& read, PosRange r, int adapter_edist) const {
-    return find_best_adapter_match(m_settings.adapter, read.seq, adapter_edist,
-                                   //including spacer region in search
-                                   {r.first, std::min(r.second + m_settings.pore_adapter_range,
-                                                      (uint64_t)read.seq.size())})
-            .has_value();
+bool DuplexSplitNode::check_nearby_adapter(const ExtRead& read,
+                                           PosRange r,
+                                           int adapter_edist) const {
+    //including spacer region in search
+    const uint64_t search_end =
+            std::min(r.second + m_settings.pore_adapter_range, (uint64_t)read.read->seq.size());
+    return read.adapter_index.best_match({r.first, search_end}, adapter_edist).has_value();
 }
 
 //'spacer' is region potentially containing templ/compl strand boundary
@@ -294,7 +379,8 @@ DuplexSplitNode::check_flank_match(const Read& read, PosRange spacer, float err_
 }
 
 std::optional<DuplexSplitNode::PosRange> DuplexSplitNode::identify_middle_adapter_split(
-        const Read& read) const {
+        const ExtRead& ext_read) const {
+    const Read& read = *ext_read.read;
     assert(m_settings.strand_end_flank > m_settings.strand_end_trim + m_settings.min_flank);
     const uint64_t r_l = read.seq.size();
     const uint64_t search_span =
@@ -305,11 +391,11 @@ std::optional<DuplexSplitNode::PosRange> DuplexSplitNode::identify_middle_adapte
     }
 
     spdlog::trace("Searching for adapter match");
-    if (auto adapter_match = find_best_adapter_match(
-                m_settings.adapter, read.seq, m_settings.relaxed_adapter_edist,
-                {r_l / 2 - search_span / 2, r_l / 2 + search_span / 2})) {
-        const uint64_t adapter_start = adapter_match->first;
-        const uint64_t adapter_end = adapter_match->second;
+    if (auto adapter_match = ext_read.adapter_index.best_match(
+                {r_l / 2 - search_span / 2, r_l / 2 + search_span / 2},
+                m_settings.relaxed_adapter_edist)) {
+        const uint64_t adapter_start = adapter_match->range.first;
+        const uint64_t adapter_end = adapter_match->range.second;
         spdlog::trace("Checking middle match & start/end match");
         //Checking match around adapter
         if (check_flank_match(read, {adapter_start, adapter_start}, m_settings.flank_err)) {
@@ -419,8 +505,7 @@ DuplexSplitNode::build_split_finders() const {
     std::vector<std::pair<std::string, SplitFinderF>> split_finders;
     split_finders.push_back({"PORE_ADAPTER", [&](const ExtRead& read) {
                                  return filter_ranges(read.possible_pore_regions, [&](PosRange r) {
-                                     return check_nearby_adapter(*read.read, r,
-                                                                 m_settings.adapter_edist);
+                                     return check_nearby_adapter(read, r, m_settings.adapter_edist);
                                  });
                              }});
 
@@ -442,7 +527,7 @@ DuplexSplitNode::build_split_finders() const {
                              filter_ranges(read.possible_pore_regions,
                                            [&](PosRange r) {
                                                return check_nearby_adapter(
-                                                              *read.read, r,
+                                                              read, r,
                                                               m_settings.relaxed_adapter_edist) &&
                                                       check_flank_match(
                                                               *read.read, r,
@@ -453,7 +538,8 @@ DuplexSplitNode::build_split_finders() const {
 
         split_finders.push_back(
                 {"ADAPTER_FLANK", [&](const ExtRead& read) {
-                     return filter_ranges(find_adapter_matches(m_settings.adapter, read.read->seq,
+                     return filter_ranges(find_adapter_matches(read.adapter_index,
+                                                               read.read->seq.size(),
                                                                m_settings.adapter_edist,
                                                                m_settings.expect_adapter_prefix),
                                           [&](PosRange r) {
@@ -464,7 +550,7 @@ DuplexSplitNode::build_split_finders() const {
                  }});
 
         split_finders.push_back({"ADAPTER_MIDDLE", [&](const ExtRead& read) {
-                                     if (auto split = identify_middle_adapter_split(*read.read)) {
+                                     if (auto split = identify_middle_adapter_split(read)) {
                                          return PosRanges{*split};
                                      } else {
                                          return PosRanges();
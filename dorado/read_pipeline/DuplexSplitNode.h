@@ -1,5 +1,6 @@
 #pragma once
 #include "ReadPipeline.h"
+#include "utils/adapter_index.h"
 #include "utils/stats.h"
 #include "utils/types.h"
 
@@ -71,20 +72,20 @@ private:
     //TODO consider precomputing and reusing ranges with high signal
     struct ExtRead {
         std::shared_ptr<Read> read;
-        torch::Tensor data_as_float32;
         std::vector<uint64_t> move_sums;
         PosRanges possible_pore_regions;
+        utils::AdapterIndex adapter_index;
     };
 
     typedef std::function<PosRanges(const ExtRead&)> SplitFinderF;
 
     ExtRead create_ext_read(std::shared_ptr<Read> r) const;
     std::vector<PosRange> possible_pore_regions(const ExtRead& read) const;
-    bool check_nearby_adapter(const Read& read, PosRange r, int adapter_edist) const;
+    bool check_nearby_adapter(const ExtRead& read, PosRange r, int adapter_edist) const;
     std::optional<std::pair<PosRange, PosRange>> check_flank_match(const Read& read,
                                                                    PosRange r,
                                                                    float err_thr) const;
-    std::optional<PosRange> identify_middle_adapter_split(const Read& read) const;
+    std::optional<PosRange> identify_middle_adapter_split(const ExtRead& read) const;
     std::optional<PosRange> identify_extra_middle_split(const Read& read) const;
 
     std::vector<std::shared_ptr<Read>> subreads(std::shared_ptr<Read> read,
@@ -5,6 +5,7 @@
 #include "nn/ModBaseRunner.h"
 #include "utils/base_mod_utils.h"
 #include "utils/math_utils.h"
+#include "utils/motif_scanner.h"
 #include "utils/sequence_utils.h"
 #include "utils/stats.h"
 #include "utils/tensor_utils.h"
@@ -12,13 +13,17 @@
 #include <nvtx3/nvtx3.hpp>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstring>
+#include <optional>
 using namespace std::chrono_literals;
 
 namespace dorado {
 
 constexpr auto FORCE_TIMEOUT = 100ms;
+// Largest number of samples of kmer encoding, at 4 bytes per base of the kmer, to create at once.
+constexpr size_t ENCODING_WINDOW_SAMPLES = 1 << 16;
 
 ModBaseCallerNode::ModBaseCallerNode(std::vector<std::unique_ptr<ModBaseRunner>> model_runners,
                                      size_t remora_threads,
@@ -32,6 +37,7 @@ ModBaseCallerNode::ModBaseCallerNode(std::vector<std::unique_ptr<ModBaseRunner>>
           // TODO -- more principled calculation of output queue size
           m_processed_chunks(10 * max_reads) {
     init_modbase_info();
+    init_shared_inputs();
     for (int i = 0; i < m_runners[0]->num_callers(); i++) {
         m_chunk_queues.emplace_back(
                 std::make_unique<utils::AsyncQueue<std::shared_ptr<RemoraChunk>>>(m_batch_size *
@@ -162,6 +168,45 @@ void ModBaseCallerNode::init_modbase_info() {
     get_modbase_info_and_maybe_init(base_mod_params, this);
 }
 
+void ModBaseCallerNode::init_shared_inputs() {
+    auto& runner = m_runners[0];
+    const auto same_scaling = [](const ModBaseParams& a, const ModBaseParams& b) {
+        if (a.refine_do_rough_rescale != b.refine_do_rough_rescale) {
+            return false;
+        }
+        return !a.refine_do_rough_rescale || (a.refine_kmer_levels == b.refine_kmer_levels &&
+                                              a.refine_kmer_len == b.refine_kmer_len &&
+                                              a.refine_kmer_center_idx == b.refine_kmer_center_idx);
+    };
+    const auto same_encoding = [](const ModBaseParams& a, const ModBaseParams& b) {
+        return a.bases_before == b.bases_before && a.bases_after == b.bases_after &&
+               a.context_before + a.context_after == b.context_before + b.context_after;
+    };
+
+    std::vector<std::string> motifs;
+    std::vector<size_t> motif_offsets;
+    m_signal_source.resize(runner->num_callers());
+    m_encoding_source.resize(runner->num_callers());
+    for (size_t caller_id = 0; caller_id < runner->num_callers(); ++caller_id) {
+        const auto& params = runner->caller_params(caller_id);
+        motifs.push_back(params.motif);
+        motif_offsets.push_back(params.motif_offset);
+        m_signal_source[caller_id] = caller_id;
+        m_encoding_source[caller_id] = caller_id;
+        for (size_t other_id = caller_id; other_id-- > 0;) {
+            // Searching backwards leaves each source as the first equivalent caller.
+            const auto& other_params = runner->caller_params(other_id);
+            if (same_scaling(params, other_params)) {
+                m_signal_source[caller_id] = other_id;
+            }
+            if (same_encoding(params, other_params)) {
+                m_encoding_source[caller_id] = other_id;
+            }
+        }
+    }
+    m_motif_scanner = utils::MotifScanner(motifs, motif_offsets);
+}
+
 void ModBaseCallerNode::input_worker_thread() {
     torch::InferenceMode inference_mode_guard;
 
@@ -179,17 +224,9 @@ void ModBaseCallerNode::input_worker_thread() {
 
         while (true) {
             stats::Timer timer;
-            {
-                nvtx3::scoped_range range{"base_mod_probs_init"};
-                // initialize base_mod_probs _before_ we start handing out chunks
-                read->base_mod_probs.resize(read->seq.size() * m_num_states, 0);
-                for (size_t i = 0; i < read->seq.size(); ++i) {
-                    // Initialize for what corresponds to 100% canonical base for each position.
-                    int base_id = RemoraUtils::BASE_IDS[read->seq[i]];
-                    if (base_id < 0) {
-                        throw std::runtime_error("Invalid character in sequence.");
-                    }
-                    read->base_mod_probs[i * m_num_states + m_base_prob_offsets[base_id]] = 1.0f;
+            for (auto base : read->seq) {
+                if (RemoraUtils::BASE_IDS[base] < 0) {
+                    throw std::runtime_error("Invalid character in sequence.");
                 }
             }
             read->base_mod_info = m_base_mod_info;
@@ -203,43 +240,104 @@ void ModBaseCallerNode::input_worker_thread() {
 
             // all runners have the same set of callers, so we only need to use the first one
             auto& runner = m_runners[0];
+            // Scaled signals and encoders of the read, computed on demand and shared between
+            // callers with the same parameters.
+            std::vector<torch::Tensor> scaled_signals(runner->num_callers());
+            std::vector<std::optional<RemoraEncoder>> encoders(runner->num_callers());
+            std::vector<std::vector<uint32_t>> caller_context_hits;
+            {
+                nvtx3::scoped_range range{"base_mod_probs_init"};
+                // Only positions in a context of some caller can have a modification, so only
+                // they get rows of probabilities.  The rows must exist _before_ we start
+                // handing out chunks.
+                read->base_mod_positions.clear();
+                caller_context_hits = m_motif_scanner.scan(read->seq);
+                for (size_t caller_id = 0; caller_id < runner->num_callers(); ++caller_id) {
+                    read->base_mod_positions.insert(read->base_mod_positions.end(),
+                                                    caller_context_hits[caller_id].begin(),
+                                                    caller_context_hits[caller_id].end());
+                }
+                std::sort(read->base_mod_positions.begin(), read->base_mod_positions.end());
+                read->base_mod_positions.erase(std::unique(read->base_mod_positions.begin(),
+                                                           read->base_mod_positions.end()),
+                                               read->base_mod_positions.end());
+                read->base_mod_probs.assign(read->base_mod_positions.size() * m_num_states, 0);
+                for (size_t row = 0; row < read->base_mod_positions.size(); ++row) {
+                    // Initialize for what corresponds to 100% canonical base for each position.
+                    int base_id = RemoraUtils::BASE_IDS[read->seq[read->base_mod_positions[row]]];
+                    read->base_mod_probs[row * m_num_states + m_base_prob_offsets[base_id]] = 1.0f;
+                }
+            }
+
             for (size_t caller_id = 0; caller_id < runner->num_callers(); ++caller_id) {
                 nvtx3::scoped_range range{"generate_chunks"};
                 auto& chunk_queue = m_chunk_queues.at(caller_id);
 
+                const auto& context_hits = caller_context_hits[caller_id];
+                m_num_context_hits += static_cast<int64_t>(context_hits.size());
+                if (context_hits.empty()) {
+                    continue;
+                }
+
                 // scale signal based on model parameters
-                auto scaled_signal = runner->scale_signal(caller_id, read->raw_data, sequence_ints,
-                                                          seq_to_sig_map);
+                auto& scaled_signal = scaled_signals[m_signal_source[caller_id]];
+                if (!scaled_signal.defined()) {
+                    scaled_signal = runner->scale_signal(caller_id, read->raw_data, sequence_ints,
+                                                         seq_to_sig_map);
+                }
 
-                auto& params = runner->caller_params(caller_id);
-                auto context_samples = (params.context_before + params.context_after);
                 // One-hot encodes the kmer at each signal step for input into the network
-                RemoraEncoder encoder(m_block_stride, context_samples, params.bases_before,
-                                      params.bases_after);
-                encoder.init(sequence_ints, seq_to_sig_map);
+                auto& params = runner->caller_params(caller_id);
+                const size_t context_samples = params.context_before + params.context_after;
+                auto& encoder = encoders[m_encoding_source[caller_id]];
+                if (!encoder) {
+                    encoder.emplace(m_block_stride, context_samples, params.bases_before,
+                                    params.bases_after);
+                    encoder->init(sequence_ints, seq_to_sig_map);
+                }
 
-                auto context_hits = runner->get_motif_hits(caller_id, read->seq);
-                m_num_context_hits += static_cast<int64_t>(context_hits.size());
-                std::vector<std::shared_ptr<RemoraChunk>> reads_to_enqueue;
-                reads_to_enqueue.reserve(context_hits.size());
-                for (auto context_hit : context_hits) {
-                    nvtx3::scoped_range range{"create_chunk"};
-                    auto slice = encoder.get_context(context_hit);
-                    // signal
-                    auto input_signal = scaled_signal.index({torch::indexing::Slice(
-                            slice.first_sample, slice.first_sample + slice.num_samples)});
-                    if (slice.lead_samples_needed != 0 || slice.tail_samples_needed != 0) {
-                        input_signal = torch::constant_pad_nd(input_signal,
-                                                              {(int64_t)slice.lead_samples_needed,
-                                                               (int64_t)slice.tail_samples_needed});
+                // The hits are encoded a window at a time, so the encoding of a long read is
+                // never held whole.  Hits are in sequence order, so each window spans a run of
+                // contexts.  Chunks only refer to the scaled signal and their window, and are
+                // allocated together, so creating one doesn't touch the heap.  The slab and its
+                // window are freed once the last of its chunks has been called.
+                const size_t window_samples = std::max(ENCODING_WINDOW_SAMPLES, context_samples);
+                size_t hit_idx = 0;
+                while (hit_idx < context_hits.size()) {
+                    nvtx3::scoped_range range{"create_chunks"};
+                    const size_t window_first_hit = hit_idx;
+                    std::vector<RemoraEncoder::Context> contexts;
+                    do {
+                        auto context = encoder->get_context_bounds(context_hits[hit_idx]);
+                        if (!contexts.empty() && context.encoding_row + context_samples >
+                                                         contexts.front().encoding_row +
+                                                                 window_samples) {
+                            break;
+                        }
+                        contexts.push_back(context);
+                        ++hit_idx;
+                    } while (hit_idx < context_hits.size());
+
+                    const size_t window_row = contexts.front().encoding_row;
+                    const size_t window_rows =
+                            contexts.back().encoding_row + context_samples - window_row;
+                    const auto window = encoder->encode_rows(window_row, window_rows);
+
+                    auto chunk_slab = std::make_shared<std::vector<RemoraChunk>>();
+                    chunk_slab->reserve(contexts.size());
+                    for (size_t i = 0; i < contexts.size(); ++i) {
+                        const auto& context = contexts[i];
+                        chunk_slab->emplace_back(read, scaled_signal,
+                                                 int64_t(context.first_sample) -
+                                                         int64_t(context.lead_samples_needed),
+                                                 window, int64_t(context.encoding_row - window_row),
+                                                 context_hits[window_first_hit + i]);
+
+                        ++read->num_modbase_chunks;
+                    }
+                    for (auto& chunk : *chunk_slab) {
+                        chunk_queue->try_push(std::shared_ptr<RemoraChunk>(chunk_slab, &chunk));
                     }
-                    reads_to_enqueue.push_back(std::make_shared<RemoraChunk>(
-                            read, input_signal, std::move(slice.data), context_hit));
-
-                    ++read->num_modbase_chunks;
-                }
-                for (auto& chunk : reads_to_enqueue) {
-                    chunk_queue->try_push(std::move(chunk));
                 }
             }
             m_chunk_generation_ms += timer.GetElapsedMS();
@@ -272,6 +370,8 @@ void ModBaseCallerNode::modbasecall_worker_thread(size_t worker_id, size_t calle
     auto& chunk_queue = m_chunk_queues[caller_id];
 
     std::vector<std::shared_ptr<RemoraChunk>> batched_chunks;
+    // The batch being called by the model while the next one is filled.
+    SubmittedBatch pending_batch;
     auto last_chunk_reserve_time = std::chrono::system_clock::now();
 
     size_t previous_chunk_count = 0;
@@ -288,6 +388,10 @@ void ModBaseCallerNode::modbasecall_worker_thread(size_t worker_id, size_t calle
         if (status == utils::AsyncQueueStatus::Terminate) {
             break;
         }
+        if (status == utils::AsyncQueueStatus::Timeout && batched_chunks.empty()) {
+            // Nothing new has arrived, so don't hold on to the results of the last batch.
+            complete_batch(pending_batch);
+        }
 
         // Reset timeout.
         last_chunk_reserve_time = std::chrono::system_clock::now();
@@ -300,7 +404,7 @@ void ModBaseCallerNode::modbasecall_worker_thread(size_t worker_id, size_t calle
              ++chunk_idx) {
             assert(chunk_idx < m_batch_size);
             const auto& chunk = batched_chunks[chunk_idx];
-            runner->accept_chunk(caller_id, chunk_idx, chunk->signal, chunk->encoded_kmers);
+            runner->accept_chunk(caller_id, chunk_idx, *chunk);
         }
 
         // If we have a complete batch, or we have a partial batch and timed out,
@@ -308,7 +412,7 @@ void ModBaseCallerNode::modbasecall_worker_thread(size_t worker_id, size_t calle
         if (batched_chunks.size() == m_batch_size ||
             (status == utils::AsyncQueueStatus::Timeout && !batched_chunks.empty())) {
             // Input tensor is full, let's get scores.
-            call_current_batch(worker_id, caller_id, batched_chunks);
+            call_current_batch(worker_id, caller_id, batched_chunks, pending_batch);
         }
 
         previous_chunk_count = batched_chunks.size();
@@ -316,8 +420,9 @@ void ModBaseCallerNode::modbasecall_worker_thread(size_t worker_id, size_t calle
 
     // Basecall any remaining chunks.
     if (!batched_chunks.empty()) {
-        call_current_batch(worker_id, caller_id, batched_chunks);
+        call_current_batch(worker_id, caller_id, batched_chunks, pending_batch);
     }
+    complete_batch(pending_batch);
 
     // Reduce the count of active model callers.  If this was the last active
     // model caller also send termination signal to sink
@@ -330,11 +435,31 @@ void ModBaseCallerNode::modbasecall_worker_thread(size_t worker_id, size_t calle
 void ModBaseCallerNode::call_current_batch(
         size_t worker_id,
         size_t caller_id,
-        std::vector<std::shared_ptr<RemoraChunk>>& batched_chunks) {
+        std::vector<std::shared_ptr<RemoraChunk>>& batched_chunks,
+        SubmittedBatch& pending_batch) {
     nvtx3::scoped_range loop{"call_current_batch"};
 
+    // Submitting this batch may wait for the model to finish with the inputs of the one before
+    // the pending batch, and the pending batch's results are only waited for once this batch is
+    // queued, so the model is kept busy while results are processed and new chunks accepted.
     dorado::stats::Timer timer;
-    auto results = m_runners[worker_id]->call_chunks(caller_id, batched_chunks.size());
+    auto scores = m_runners[worker_id]->submit_chunks(caller_id, batched_chunks.size());
+    m_call_chunks_ms += timer.GetElapsedMS();
+
+    complete_batch(pending_batch);
+    pending_batch.chunks = std::move(batched_chunks);
+    pending_batch.scores = std::move(scores);
+    batched_chunks.clear();
+    ++m_num_batches_called;
+}
+
+void ModBaseCallerNode::complete_batch(SubmittedBatch& batch) {
+    if (batch.chunks.empty()) {
+        return;
+    }
+
+    dorado::stats::Timer timer;
+    const auto& results = batch.scores.get();
     m_call_chunks_ms += timer.GetElapsedMS();
 
     // Convert results to float32 with one call and address via a raw pointer,
@@ -346,15 +471,15 @@ void ModBaseCallerNode::call_current_batch(
     auto row_size = results.size(1);
 
     // Put results into chunk
-    for (size_t i = 0; i < batched_chunks.size(); ++i) {
-        auto& chunk = batched_chunks[i];
+    for (size_t i = 0; i < batch.chunks.size(); ++i) {
+        auto& chunk = batch.chunks[i];
         chunk->scores.resize(row_size);
         std::memcpy(chunk->scores.data(), &results_f32_ptr[i * row_size], row_size * sizeof(float));
         m_processed_chunks.try_push(std::move(chunk));
     }
 
-    batched_chunks.clear();
-    ++m_num_batches_called;
+    batch.chunks.clear();
+    batch.scores = {};
 }
 
 void ModBaseCallerNode::output_worker_thread() {
@@ -375,8 +500,12 @@ void ModBaseCallerNode::output_worker_thread() {
             int64_t result_pos = chunk->context_hit;
             int64_t offset =
                     m_base_prob_offsets[RemoraUtils::BASE_IDS[source_read->seq[result_pos]]];
+            const auto& positions = source_read->base_mod_positions;
+            const int64_t row =
+                    std::lower_bound(positions.begin(), positions.end(), result_pos) -
+                    positions.begin();
             for (size_t i = 0; i < chunk->scores.size(); ++i) {
-                source_read->base_mod_probs[m_num_states * result_pos + offset + i] =
+                source_read->base_mod_probs[m_num_states * row + offset + i] =
                         static_cast<uint8_t>(std::min(std::floor(chunk->scores[i] * 256), 255.0f));
             }
             ++source_read->num_modbase_chunks_called;
@@ -2,6 +2,7 @@
 
 #include "ReadPipeline.h"
 #include "utils/AsyncQueue.h"
+#include "utils/motif_scanner.h"
 #include "utils/stats.h"
 
 #include <array>
@@ -10,6 +11,7 @@
 #include <cstdint>
 #include <deque>
 #include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -57,16 +59,31 @@ private:
     // Determine the modbase alphabet from all callers and calculate offset positions for the results
     void init_modbase_info();
 
+    // Determine which callers can share a read's scaled signal and kmer encoding, and set up
+    // the scan for all of their motifs
+    void init_shared_inputs();
+
     // Worker threads, scales and chunks reads for runners and enqueues them
     void input_worker_thread();
 
     // Worker threads, performs the GPU calls to the modbase models
     void modbasecall_worker_thread(size_t worker_id, size_t caller_id);
 
-    // Called by modbasecall_worker_thread, calls the model and enqueues the results
+    // A batch of chunks submitted to a runner, whose scores may not be ready yet.
+    struct SubmittedBatch {
+        std::vector<std::shared_ptr<RemoraChunk>> chunks;
+        std::shared_future<torch::Tensor> scores;
+    };
+
+    // Called by modbasecall_worker_thread, submits the batch to the model and completes the
+    // previously submitted batch, which the new one replaces as pending
     void call_current_batch(size_t worker_id,
                             size_t caller_id,
-                            std::vector<std::shared_ptr<RemoraChunk>>& batched_chunks);
+                            std::vector<std::shared_ptr<RemoraChunk>>& batched_chunks,
+                            SubmittedBatch& pending_batch);
+
+    // Waits for the batch's scores and enqueues its chunks with them
+    void complete_batch(SubmittedBatch& batch);
 
     // Worker thread, processes chunk results back into the reads
     void output_worker_thread();
@@ -98,6 +115,12 @@ private:
     // The offsets to the canonical bases in the modbase alphabet
     std::array<size_t, 4> m_base_prob_offsets;
     size_t m_num_states{4};
+    // For each caller, the first caller whose scaled signal and kmer encoding of a read are the
+    // same as its own, so they only need computing once per read.
+    std::vector<size_t> m_signal_source;
+    std::vector<size_t> m_encoding_source;
+    // Finds the context hits of every caller in one pass over a read.
+    utils::MotifScanner m_motif_scanner;
 
     // Performance monitoring stats.
     std::atomic<int64_t> m_num_batches_called = 0;
@@ -1,6 +1,6 @@
 #include "PairingNode.h"
 
-#include "minimap.h"
+#include "utils/sequence_utils.h"
 
 #include <nvtx3/nvtx3.hpp>
 #include <spdlog/spdlog.h>
@@ -8,11 +8,83 @@
 #include <algorithm>
 #include <cstdint>
 #include <limits>
+#include <optional>
 
 namespace {
 const int kMaxTimeDeltaMs = 1000;
 const float kMinSeqLenRatio = 0.2f;
 const int kMinOverlapLength = 50;
+
+// The overlap prefilter compares a sample of the canonical kmers of each read.
+const int kSketchKmerLen = 15;
+const uint64_t kSketchSampleRate = 8;
+// Below this many sampled kmers a sketch says too little to reject a pair.
+const size_t kMinSketchSize = 20;
+// Fraction of the smaller sketch which must be shared by a pair.
+const float kMinSketchContainment = 0.02f;
+
+uint64_t mix_kmer(uint64_t kmer) {
+    kmer ^= kmer >> 33;
+    kmer *= 0xff51afd7ed558ccdULL;
+    kmer ^= kmer >> 33;
+    kmer *= 0xc4ceb9fe1a85ec53ULL;
+    return kmer ^ (kmer >> 33);
+}
+
+// Sorted, unique hashes of the sampled canonical kmers of `seq`.  Canonical kmers are the same
+// on both strands, so a template and its complement share them.
+std::vector<uint64_t> overlap_sketch(const std::string& seq) {
+    const uint64_t kmer_mask = (uint64_t(1) << (2 * kSketchKmerLen)) - 1;
+    const int rc_shift = 2 * (kSketchKmerLen - 1);
+
+    std::vector<uint64_t> sketch;
+    sketch.reserve(seq.length() / kSketchSampleRate + 1);
+    uint64_t fwd_kmer = 0;
+    uint64_t rev_kmer = 0;
+    for (size_t i = 0; i < seq.length(); ++i) {
+        const uint64_t base = dorado::utils::base_to_int(seq[i]);
+        fwd_kmer = ((fwd_kmer << 2) | base) & kmer_mask;
+        rev_kmer = (rev_kmer >> 2) | ((3 - base) << rc_shift);
+        if (i + 1 < size_t(kSketchKmerLen)) {
+            continue;
+        }
+        const uint64_t hash = mix_kmer(std::min(fwd_kmer, rev_kmer));
+        if (hash % kSketchSampleRate == 0) {
+            sketch.push_back(hash);
+        }
+    }
+    std::sort(sketch.begin(), sketch.end());
+    sketch.erase(std::unique(sketch.begin(), sketch.end()), sketch.end());
+    return sketch;
+}
+
+// Returns false if the sketches of two reads are too different for them to overlap.  The shared
+// fraction of the smaller sketch is used rather than the Jaccard index, as pairs may differ in
+// length by up to kMinSeqLenRatio.
+bool sketches_may_overlap(const std::vector<uint64_t>& sketch1,
+                          const std::vector<uint64_t>& sketch2) {
+    const size_t min_size = std::min(sketch1.size(), sketch2.size());
+    if (min_size < kMinSketchSize) {
+        return true;
+    }
+
+    size_t shared = 0;
+    auto it1 = sketch1.begin();
+    auto it2 = sketch2.begin();
+    while (it1 != sketch1.end() && it2 != sketch2.end()) {
+        if (*it1 < *it2) {
+            ++it1;
+        } else if (*it2 < *it1) {
+            ++it2;
+        } else {
+            ++shared;
+            ++it1;
+            ++it2;
+        }
+    }
+    return shared >= std::max(size_t(2), size_t(kMinSketchContainment * min_size));
+}
+
 }  // namespace
 
 namespace dorado {
@@ -23,7 +95,9 @@ namespace dorado {
 //    lengths must be at least 20%.
 // 2. If the lengths are >98% similar, reads are at least 5KB, and time
 //    delta is <100ms, consider them to be a pair.
-// 3. If the early acceptance fails, then run minimap2 to generate overlap
+// 3. If the early acceptance fails, reject reads which share too few sampled
+//    kmers to overlap.
+// 4. Otherwise run minimap2 to generate overlap
 //    coordinates. If there is only 1 hit from minimap2 mapping,
 //    the mapping quality is high (>50), the overlap covers
 //    most of the shorter read (80%), the overlap is at least 50 bp long,
@@ -32,7 +106,9 @@ namespace dorado {
 //    of the complement read, then consider them a pair.
 PairingNode::PairingResult PairingNode::is_within_time_and_length_criteria(
         const std::shared_ptr<dorado::Read>& temp,
+        const std::vector<uint64_t>& temp_sketch,
         const std::shared_ptr<dorado::Read>& comp,
+        const std::vector<uint64_t>& comp_sketch,
         int tid) {
     int delta = comp->start_time_ms - temp->get_end_time_ms();
     int seq_len1 = temp->seq.length();
@@ -57,6 +133,11 @@ PairingNode::PairingResult PairingNode::is_within_time_and_length_criteria(
         return {true, 0, temp->seq.length() - 1, 0, comp->seq.length() - 1};
     }
 
+    if (!sketches_may_overlap(temp_sketch, comp_sketch)) {
+        m_sketch_rejected_pairs++;
+        return {false, 0, 0, 0, 0};
+    }
+
     return is_within_alignment_criteria(temp, comp, delta, true, tid);
 }
 
@@ -69,25 +150,22 @@ PairingNode::PairingResult PairingNode::is_within_alignment_criteria(
     PairingResult pair_result = {false, 0, 0, 0, 0};
     const std::string nvtx_id = "pairing_map_" + std::to_string(tid);
     nvtx3::scoped_range loop{nvtx_id};
-    // Add mm2 based overlap check.
-    mm_idxopt_t m_idx_opt;
-    mm_mapopt_t m_map_opt;
-    mm_set_opt(0, &m_idx_opt, &m_map_opt);
-    mm_set_opt("map-hifi", &m_idx_opt, &m_map_opt);
 
+    // Add mm2 based overlap check.
     std::vector<const char*> seqs = {temp->seq.c_str()};
     std::vector<const char*> names = {temp->read_id.c_str()};
-    mm_idx_t* m_index = mm_idx_str(m_idx_opt.w, m_idx_opt.k, 0, m_idx_opt.bucket_bits, 1,
-                                   seqs.data(), names.data());
-    mm_mapopt_update(&m_map_opt, m_index);
+    mm_idx_t* index = mm_idx_str(m_idx_opt.w, m_idx_opt.k, 0, m_idx_opt.bucket_bits, 1,
+                                 seqs.data(), names.data());
+    mm_mapopt_t map_opt = m_map_opt;
+    mm_mapopt_update(&map_opt, index);
 
     mm_tbuf_t* tbuf = m_tbufs[tid].get();
 
     int hits = 0;
-    mm_reg1_t* reg = mm_map(m_index, comp->seq.length(), comp->seq.c_str(), &hits, tbuf, &m_map_opt,
+    mm_reg1_t* reg = mm_map(index, comp->seq.length(), comp->seq.c_str(), &hits, tbuf, &map_opt,
                             comp->read_id.c_str());
 
-    mm_idx_destroy(m_index);
+    mm_idx_destroy(index);
 
     // Multiple hits implies ambiguous mapping, so ignore those pairs.
     if (hits == 1 || (!allow_rejection && hits > 0)) {
@@ -227,6 +305,24 @@ void PairingNode::pair_list_worker_thread(int tid) {
     --m_num_active_worker_threads;
 }
 
+uint32_t PairingNode::intern_id(const std::string& id) {
+    {
+        std::shared_lock<std::shared_mutex> lock(m_interned_ids_mutex);
+        auto it = m_interned_ids.find(id);
+        if (it != m_interned_ids.end()) {
+            return it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(m_interned_ids_mutex);
+    return m_interned_ids.emplace(id, uint32_t(m_interned_ids.size())).first->second;
+}
+
+PairingNode::PairingShard& PairingNode::get_shard(int32_t client_id,
+                                                  const UniquePoreIdentifierKey& key) {
+    const auto hash = UniquePoreIdentifierKeyHash{}(key) ^ (uint32_t(client_id) * 0x9e3779b9u);
+    return m_shards[hash % kNumPairingShards];
+}
+
 void PairingNode::pair_generating_worker_thread(int tid) {
     torch::InferenceMode inference_mode_guard;
 
@@ -238,17 +334,24 @@ void PairingNode::pair_generating_worker_thread(int tid) {
     Message message;
     while (get_input_message(message)) {
         if (std::holds_alternative<CacheFlushMessage>(message)) {
-            std::unique_lock<std::mutex> lock(m_pairing_mtx);
             auto flush_message = std::get<CacheFlushMessage>(message);
-            auto& read_cache = m_read_caches[flush_message.client_id];
-            for (const auto& [key, reads_list] : read_cache.channel_mux_read_map) {
-                // kv is a std::pair<UniquePoreIdentifierKey, std::list<std::shared_ptr<Read>>>
-                for (const auto& read_ptr : reads_list) {
-                    // Push each read message
-                    send_message_to_sink(std::move(read_ptr));
+            for (auto& shard : m_shards) {
+                std::unique_lock<std::mutex> lock(shard.mutex);
+                auto read_cache_iter = shard.read_caches.find(flush_message.client_id);
+                if (read_cache_iter == shard.read_caches.end()) {
+                    continue;
+                }
+                for (const auto& [key, reads_list] : read_cache_iter->second.channel_mux_read_map) {
+                    for (const auto& read_ptr : reads_list) {
+                        shard.sketches.erase(read_ptr);
+                        // Push each read message
+                        send_message_to_sink(read_ptr);
+                    }
                 }
+                shard.read_caches.erase(read_cache_iter);
             }
-            m_read_caches.erase(flush_message.client_id);
+            std::lock_guard<std::mutex> pore_order_lock(m_pore_order_mutex);
+            m_pore_order.erase(flush_message.client_id);
             continue;
         }
 
@@ -262,62 +365,64 @@ void PairingNode::pair_generating_worker_thread(int tid) {
         const std::string nvtx_id = "pairing_code_" + std::to_string(tid);
         nvtx3::scoped_range loop{nvtx_id};
         auto read = std::get<std::shared_ptr<Read>>(message);
+        // Built before taking the lock, and kept while the read is cached, so that each read is
+        // only sketched once however many pairs it is evaluated in.
+        auto sketch = std::make_shared<const std::vector<uint64_t>>(overlap_sketch(read->seq));
 
-        int channel = read->attributes.channel_number;
-        int mux = read->attributes.mux;
-        std::string run_id = read->run_id;
-        std::string flowcell_id = read->flowcell_id;
+        const UniquePoreIdentifierKey key{read->attributes.channel_number, read->attributes.mux,
+                                          intern_id(read->run_id), intern_id(read->flowcell_id)};
         int32_t client_id = read->client_id;
+        auto& shard = get_shard(client_id, key);
 
-        std::unique_lock<std::mutex> lock(m_pairing_mtx);
+        std::unique_lock<std::mutex> lock(shard.mutex);
 
-        auto& read_cache = m_read_caches[client_id];
-        UniquePoreIdentifierKey key = std::make_tuple(channel, mux, run_id, flowcell_id);
+        shard.sketches.emplace(read, sketch);
+        auto& read_cache = shard.read_caches[client_id];
         auto read_list_iter = read_cache.channel_mux_read_map.find(key);
+        std::optional<UniquePoreIdentifierKey> evicted_key;
         // Check if the key is already in the list
         if (read_list_iter == read_cache.channel_mux_read_map.end()) {
-            // Key is not in the dequeue
-            // Add the new key to the end of the list
-            read_cache.working_channel_mux_keys.push_back(key);
             read_cache.channel_mux_read_map.insert({key, {read}});
 
-            if (read_cache.working_channel_mux_keys.size() > m_max_num_keys) {
-                // Remove the oldest key (front of the list)
-                auto oldest_key = read_cache.working_channel_mux_keys.front();
-                read_cache.working_channel_mux_keys.pop_front();
-
-                auto oldest_key_it = read_cache.channel_mux_read_map.find(oldest_key);
-
-                // Remove the oldest key from the map
-                for (auto read_ptr : oldest_key_it->second) {
-                    m_reads_to_clear.insert(std::move(read_ptr));
-                }
-                read_cache.channel_mux_read_map.erase(oldest_key);
-                assert(read_cache.channel_mux_read_map.size() ==
-                       read_cache.working_channel_mux_keys.size());
+            // Add the new key to the end of the list, and evict the oldest key of the client,
+            // which may be in another shard, if there are too many.
+            std::lock_guard<std::mutex> pore_order_lock(m_pore_order_mutex);
+            auto& pore_order = m_pore_order[client_id];
+            pore_order.push_back(key);
+            if (pore_order.size() > m_max_num_keys) {
+                evicted_key = pore_order.front();
+                pore_order.pop_front();
             }
         } else {
             auto& cached_read_list = read_list_iter->second;
             std::shared_ptr<Read> later_read, earlier_read;
-            auto later_read_iter = std::lower_bound(
-                    cached_read_list.begin(), cached_read_list.end(), read, compare_reads_by_time);
+            std::shared_ptr<const std::vector<uint64_t>> later_sketch, earlier_sketch;
+            // Reads mostly arrive in time order, so the search is usually from the back.
+            auto later_read_iter =
+                    (cached_read_list.empty() ||
+                     compare_reads_by_time(cached_read_list.back(), read))
+                            ? cached_read_list.end()
+                            : std::lower_bound(cached_read_list.begin(), cached_read_list.end(),
+                                               read, compare_reads_by_time);
             if (later_read_iter != cached_read_list.end()) {
                 later_read = *later_read_iter;
-                m_reads_in_flight_ctr[later_read]++;
+                later_sketch = shard.sketches.at(later_read);
+                shard.reads_in_flight_ctr[later_read]++;
             }
 
             if (later_read_iter != cached_read_list.begin()) {
                 earlier_read = *(std::prev(later_read_iter));
-                m_reads_in_flight_ctr[earlier_read]++;
+                earlier_sketch = shard.sketches.at(earlier_read);
+                shard.reads_in_flight_ctr[earlier_read]++;
             }
 
             cached_read_list.insert(later_read_iter, read);
-            m_reads_in_flight_ctr[read]++;
+            shard.reads_in_flight_ctr[read]++;
 
             while (cached_read_list.size() > m_max_num_reads) {
                 auto cached_read = cached_read_list.front();
                 cached_read_list.pop_front();
-                m_reads_to_clear.insert(std::move(cached_read));
+                shard.reads_to_clear.insert(std::move(cached_read));
             }
 
             // Release mutex around read cache to run pair evaluations.
@@ -325,8 +430,8 @@ void PairingNode::pair_generating_worker_thread(int tid) {
 
             bool found_pair = false;
             if (later_read) {
-                auto [is_pair, qs, qe, rs, re] =
-                        is_within_time_and_length_criteria(read, later_read, tid);
+                auto [is_pair, qs, qe, rs, re] = is_within_time_and_length_criteria(
+                        read, *sketch, later_read, *later_sketch, tid);
                 if (is_pair) {
                     ReadPair pair = {read, later_read, qs, qe, rs, re};
                     read->is_duplex_parent = true;
@@ -338,8 +443,8 @@ void PairingNode::pair_generating_worker_thread(int tid) {
             }
 
             if (!found_pair && earlier_read) {
-                auto [is_pair, qs, qe, rs, re] =
-                        is_within_time_and_length_criteria(earlier_read, read, tid);
+                auto [is_pair, qs, qe, rs, re] = is_within_time_and_length_criteria(
+                        earlier_read, *earlier_sketch, read, *sketch, tid);
                 if (is_pair) {
                     ReadPair pair = {earlier_read, read, qs, qe, rs, re};
                     earlier_read->is_duplex_parent = true;
@@ -353,58 +458,101 @@ void PairingNode::pair_generating_worker_thread(int tid) {
             lock.lock();
 
             // Decrement in-flight counter for each read.
-            m_reads_in_flight_ctr[read]--;
+            shard.reads_in_flight_ctr[read]--;
             if (earlier_read) {
-                m_reads_in_flight_ctr[earlier_read]--;
+                shard.reads_in_flight_ctr[earlier_read]--;
             }
             if (later_read) {
-                m_reads_in_flight_ctr[later_read]--;
+                shard.reads_in_flight_ctr[later_read]--;
             }
         }
 
         // Once pairs have been evaluated, check if any of the in-flight reads
         // need to be purged from the cache.
-        for (auto to_clear_itr = m_reads_to_clear.begin();
-             to_clear_itr != m_reads_to_clear.end();) {
-            auto in_flight_itr = m_reads_in_flight_ctr.find(*to_clear_itr);
-            bool ok_to_clear = false;
-            // If a read to clear is not in-flight (not in the in-flight list
-            // or in-flight counter is 0), then clear it
-            // from the cache.
-            if (in_flight_itr == m_reads_in_flight_ctr.end()) {
-                ok_to_clear = true;
-            } else if (in_flight_itr->second.load() == 0) {
-                m_reads_in_flight_ctr.erase(in_flight_itr);
-                ok_to_clear = true;
-            }
-            if (ok_to_clear) {
-                send_message_to_sink(std::move(*to_clear_itr));
-                to_clear_itr = m_reads_to_clear.erase(to_clear_itr);
-            } else {
-                ++to_clear_itr;
-            }
+        clear_reads(shard);
+
+        // The evicted pore's shard is only locked after this one is released, so that no thread
+        // holds two shard locks.
+        if (evicted_key) {
+            lock.unlock();
+            evict_pore(client_id, *evicted_key);
         }
     }
 
     if (--m_num_active_worker_threads == 0) {
-        if (!m_preserve_cache_during_flush) {
-            std::unique_lock<std::mutex> lock(m_pairing_mtx);
-            // There are still reads in channel_mux_read_map. Push them to the sink.
-            // Last thread alive is responsible for cleaning up the cache.
-            for (const auto& [client_id, read_cache] : m_read_caches) {
-                for (const auto& kv : read_cache.channel_mux_read_map) {
-                    // kv is a std::pair<UniquePoreIdentifierKey, std::list<std::shared_ptr<Read>>>
-                    const auto& reads_list = kv.second;
-
-                    for (const auto& read_ptr : reads_list) {
-                        // Push each read message
-                        send_message_to_sink(read_ptr);
+        // Last thread alive is responsible for cleaning up the cache.
+        for (auto& shard : m_shards) {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            if (!m_preserve_cache_during_flush) {
+                // There are still reads in channel_mux_read_map. Push them to the sink.
+                for (const auto& [client_id, read_cache] : shard.read_caches) {
+                    for (const auto& kv : read_cache.channel_mux_read_map) {
+                        // kv is a std::pair<UniquePoreIdentifierKey, std::deque<...>>
+                        const auto& reads_list = kv.second;
+
+                        for (const auto& read_ptr : reads_list) {
+                            // Push each read message
+                            send_message_to_sink(read_ptr);
+                        }
                     }
                 }
+                shard.read_caches.clear();
+                shard.sketches.clear();
             }
-            m_read_caches.clear();
+            // No reads are in flight any more, so reads waiting to be cleared can go too.
+            for (const auto& read_ptr : shard.reads_to_clear) {
+                shard.sketches.erase(read_ptr);
+                send_message_to_sink(read_ptr);
+            }
+            shard.reads_to_clear.clear();
+            shard.reads_in_flight_ctr.clear();
+        }
+        if (!m_preserve_cache_during_flush) {
+            std::lock_guard<std::mutex> pore_order_lock(m_pore_order_mutex);
+            m_pore_order.clear();
+        }
+    }
+}
+
+void PairingNode::evict_pore(int32_t client_id, const UniquePoreIdentifierKey& key) {
+    auto& shard = get_shard(client_id, key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto read_cache_iter = shard.read_caches.find(client_id);
+    if (read_cache_iter != shard.read_caches.end()) {
+        auto& channel_mux_read_map = read_cache_iter->second.channel_mux_read_map;
+        // The pore is gone if its client has been flushed since it was evicted.
+        auto oldest_key_it = channel_mux_read_map.find(key);
+        if (oldest_key_it != channel_mux_read_map.end()) {
+            for (auto read_ptr : oldest_key_it->second) {
+                shard.reads_to_clear.insert(std::move(read_ptr));
+            }
+            channel_mux_read_map.erase(oldest_key_it);
+        }
+    }
+    clear_reads(shard);
+}
+
+void PairingNode::clear_reads(PairingShard& shard) {
+    for (auto to_clear_itr = shard.reads_to_clear.begin();
+         to_clear_itr != shard.reads_to_clear.end();) {
+        auto in_flight_itr = shard.reads_in_flight_ctr.find(*to_clear_itr);
+        bool ok_to_clear = false;
+        // If a read to clear is not in-flight (not in the in-flight list
+        // or in-flight counter is 0), then clear it
+        // from the cache.
+        if (in_flight_itr == shard.reads_in_flight_ctr.end()) {
+            ok_to_clear = true;
+        } else if (in_flight_itr->second.load() == 0) {
+            shard.reads_in_flight_ctr.erase(in_flight_itr);
+            ok_to_clear = true;
+        }
+        if (ok_to_clear) {
+            shard.sketches.erase(*to_clear_itr);
+            send_message_to_sink(std::move(*to_clear_itr));
+            to_clear_itr = shard.reads_to_clear.erase(to_clear_itr);
+        } else {
+            ++to_clear_itr;
         }
-        m_reads_in_flight_ctr.clear();
     }
 }
 
@@ -414,6 +562,9 @@ PairingNode::PairingNode(std::map<std::string, std::string> template_complement_
         : MessageSink(max_reads),
           m_num_worker_threads(num_worker_threads),
           m_template_complement_map(std::move(template_complement_map)) {
+    mm_set_opt(0, &m_idx_opt, &m_map_opt);
+    mm_set_opt("map-hifi", &m_idx_opt, &m_map_opt);
+
     // Set up the complement-template_map
     for (auto& key : m_template_complement_map) {
         m_complement_template_map[key.second] = key.first;
@@ -428,6 +579,9 @@ PairingNode::PairingNode(ReadOrder read_order, int num_worker_threads, size_t ma
           m_num_worker_threads(num_worker_threads),
           m_max_num_keys(std::numeric_limits<size_t>::max()),
           m_max_num_reads(std::numeric_limits<size_t>::max()) {
+    mm_set_opt(0, &m_idx_opt, &m_map_opt);
+    mm_set_opt("map-hifi", &m_idx_opt, &m_map_opt);
+
     switch (read_order) {
     case ReadOrder::BY_CHANNEL:
         m_max_num_keys = 10;
@@ -479,6 +633,7 @@ stats::NamedStats PairingNode::sample_stats() const {
     stats::NamedStats stats = m_work_queue.sample_stats();
     stats["early_accepted_pairs"] = m_early_accepted_pairs.load();
     stats["overlap_accepted_pairs"] = m_overlap_accepted_pairs.load();
+    stats["sketch_rejected_pairs"] = m_sketch_rejected_pairs.load();
     return stats;
 }
 
@@ -1,31 +1,82 @@
 #pragma once
 
 #include "ReadPipeline.h"
+#include "minimap.h"
 #include "utils/stats.h"
 #include "utils/types.h"
 
+#include <array>
 #include <atomic>
+#include <cstdint>
 #include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <thread>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace dorado {
 
 class PairingNode : public MessageSink {
     // A key for a unique Pore, Duplex reads must have the same UniquePoreIdentifierKey
-    // The values are channel, mux, run_id, flowcell_id
-    using UniquePoreIdentifierKey = std::tuple<int, int, std::string, std::string>;
+    // The run_id and flowcell_id are interned, see intern_id.
+    struct UniquePoreIdentifierKey {
+        int32_t channel;
+        uint32_t mux;
+        uint32_t run_id;
+        uint32_t flowcell_id;
+
+        bool operator==(const UniquePoreIdentifierKey& other) const {
+            return channel == other.channel && mux == other.mux && run_id == other.run_id &&
+                   flowcell_id == other.flowcell_id;
+        }
+    };
+
+    struct UniquePoreIdentifierKeyHash {
+        size_t operator()(const UniquePoreIdentifierKey& key) const {
+            uint64_t hash = uint64_t(uint32_t(key.channel)) | (uint64_t(key.mux) << 32);
+            hash ^= (uint64_t(key.run_id) | (uint64_t(key.flowcell_id) << 32)) *
+                    0x9e3779b97f4a7c15ULL;
+            hash ^= hash >> 29;
+            hash *= 0xbf58476d1ce4e5b9ULL;
+            return size_t(hash ^ (hash >> 32));
+        }
+    };
 
     struct ReadCache {
-        std::map<UniquePoreIdentifierKey, std::list<std::shared_ptr<Read>>> channel_mux_read_map;
-        std::deque<UniquePoreIdentifierKey> working_channel_mux_keys;
+        // The reads of each pore, sorted by start time.
+        std::unordered_map<UniquePoreIdentifierKey,
+                           std::deque<std::shared_ptr<Read>>,
+                           UniquePoreIdentifierKeyHash>
+                channel_mux_read_map;
+    };
+
+    // Pores are spread over shards, each with its own lock, so that threads pairing reads from
+    // different pores rarely wait for each other.  A read only ever pairs with reads from its
+    // own pore, so all the state for a read lives in the shard of its pore.
+    struct PairingShard {
+        std::mutex mutex;
+
+        // individual read caches per client, keyed by client_id
+        std::unordered_map<int32_t, ReadCache> read_caches;
+
+        // Track reads which need to be emptied from the cache but are still being
+        // evaluated for pairs by other threads.
+        std::unordered_map<std::shared_ptr<Read>, std::atomic<int>> reads_in_flight_ctr;
+        std::unordered_set<std::shared_ptr<Read>> reads_to_clear;
+
+        // The overlap sketch of each cached read, built once when the read arrives and dropped
+        // when it leaves the cache.  Threads take a reference under the lock, so a sketch stays
+        // valid while its read is being evaluated.
+        std::unordered_map<std::shared_ptr<Read>, std::shared_ptr<const std::vector<uint64_t>>>
+                sketches;
     };
+    static constexpr size_t kNumPairingShards = 64;
 
 public:
     // Template-complement map: uses the pair_list pairing method
@@ -82,10 +133,26 @@ private:
 
     // Members for pair_generating method
 
-    std::mutex m_pairing_mtx;
+    std::array<PairingShard, kNumPairingShards> m_shards;
 
-    // individual read caches per client, keyed by client_id
-    std::unordered_map<int32_t, ReadCache> m_read_caches;
+    PairingShard& get_shard(int32_t client_id, const UniquePoreIdentifierKey& key);
+
+    // The pores of each client, keyed by client_id, in the order they were first seen across all
+    // shards, so that m_max_num_keys limits the pores held by the whole node.  This mutex may be
+    // taken while holding a shard's mutex, but a shard's mutex is never taken while holding it.
+    std::mutex m_pore_order_mutex;
+    std::unordered_map<int32_t, std::deque<UniquePoreIdentifierKey>> m_pore_order;
+
+    // Moves the reads of an evicted pore to the reads to clear of its shard, and clears them.
+    void evict_pore(int32_t client_id, const UniquePoreIdentifierKey& key);
+    // Sends on the reads to clear of `shard` which are no longer in flight.  The shard's mutex
+    // must be held.
+    void clear_reads(PairingShard& shard);
+
+    // Returns a small integer which identifies `id`, the same for every call with the same id.
+    uint32_t intern_id(const std::string& id);
+    std::shared_mutex m_interned_ids_mutex;
+    std::unordered_map<std::string, uint32_t> m_interned_ids;
 
     /**
      * The maximum number of different channels (pores) to keep in memory concurrently. 
@@ -105,7 +172,9 @@ private:
 
     using PairingResult = std::tuple<bool, uint32_t, uint32_t, uint32_t, uint32_t>;
     PairingResult is_within_time_and_length_criteria(const std::shared_ptr<dorado::Read>& read1,
+                                                     const std::vector<uint64_t>& sketch1,
                                                      const std::shared_ptr<dorado::Read>& read2,
+                                                     const std::vector<uint64_t>& sketch2,
                                                      int tid);
 
     PairingResult is_within_alignment_criteria(const std::shared_ptr<dorado::Read>& temp,
@@ -114,17 +183,17 @@ private:
                                                bool allow_rejection,
                                                int tid);
 
+    // map-hifi options, set up once as they are the same for every pair.
+    mm_idxopt_t m_idx_opt;
+    mm_mapopt_t m_map_opt;
+
     // Store the minimap2 buffers used for mapping. One buffer per thread.
     std::vector<MmTbufPtr> m_tbufs;
 
-    // Track reads which need to be emptied from the cache but are still being
-    // evaluated for pairs by other threads.
-    std::unordered_map<std::shared_ptr<Read>, std::atomic<int>> m_reads_in_flight_ctr;
-    std::unordered_set<std::shared_ptr<Read>> m_reads_to_clear;
-
     // Stats tracking for pairing node.
     std::atomic<int> m_early_accepted_pairs{0};
     std::atomic<int> m_overlap_accepted_pairs{0};
+    std::atomic<int> m_sketch_rejected_pairs{0};
 };
 
 }  // namespace dorado
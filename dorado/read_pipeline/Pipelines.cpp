@@ -22,7 +22,8 @@ void create_simplex_pipeline(PipelineDescriptor& pipeline_desc,
                              int scaler_node_threads,
                              int modbase_node_threads,
                              NodeHandle sink_node_handle,
-                             NodeHandle source_node_handle) {
+                             NodeHandle source_node_handle,
+                             std::shared_ptr<const utils::ChunkCache> chunk_cache) {
     auto model_stride = runners.front()->model_stride();
     auto adjusted_overlap = (overlap / model_stride) * model_stride;
     if (overlap != adjusted_overlap) {
@@ -43,7 +44,7 @@ void create_simplex_pipeline(PipelineDescriptor& pipeline_desc,
 
     auto basecaller_node = pipeline_desc.add_node<BasecallerNode>(
             {}, std::move(runners), overlap, kBatchTimeoutMS, model_name, 1000, "BasecallerNode",
-            false, get_model_mean_qscore_start_pos(model_config));
+            false, get_model_mean_qscore_start_pos(model_config), std::move(chunk_cache));
 
     NodeHandle last_node_handle = PipelineDescriptor::InvalidNodeHandle;
     if (mod_base_caller_node != PipelineDescriptor::InvalidNodeHandle) {
@@ -77,7 +78,9 @@ void create_stereo_duplex_pipeline(PipelineDescriptor& pipeline_desc,
                                    int splitter_node_threads,
                                    PairingParameters pairing_parameters,
                                    NodeHandle sink_node_handle,
-                                   NodeHandle source_node_handle) {
+                                   NodeHandle source_node_handle,
+                                   std::shared_ptr<const utils::ChunkCache> chunk_cache,
+                                   std::shared_ptr<const utils::ChunkCache> stereo_chunk_cache) {
     std::string model_name =
             std::filesystem::canonical(model_config.model_path).filename().string();
     auto stereo_model_name =
@@ -90,7 +93,7 @@ void create_stereo_duplex_pipeline(PipelineDescriptor& pipeline_desc,
     auto stereo_basecaller_node = pipeline_desc.add_node<BasecallerNode>(
             {}, std::move(stereo_runners), adjusted_stereo_overlap, kStereoBatchTimeoutMS,
             duplex_rg_name, 1000, "StereoBasecallerNode", true,
-            get_model_mean_qscore_start_pos(stereo_model_config));
+            get_model_mean_qscore_start_pos(stereo_model_config), std::move(stereo_chunk_cache));
 
     auto simplex_model_stride = runners.front()->model_stride();
     auto stereo_node = pipeline_desc.add_node<StereoDuplexEncoderNode>({stereo_basecaller_node},
@@ -119,7 +122,7 @@ void create_stereo_duplex_pipeline(PipelineDescriptor& pipeline_desc,
     auto basecaller_node = pipeline_desc.add_node<BasecallerNode>(
             {splitter_node}, std::move(runners), adjusted_simplex_overlap, kSimplexBatchTimeoutMS,
             model_name, 1000, "BasecallerNode", true,
-            get_model_mean_qscore_start_pos(model_config));
+            get_model_mean_qscore_start_pos(model_config), std::move(chunk_cache));
 
     auto scaler_node = pipeline_desc.add_node<ScalerNode>(
             {basecaller_node}, model_config.signal_norm_params, scaler_node_threads);
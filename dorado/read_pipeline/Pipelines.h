@@ -13,6 +13,9 @@ namespace dorado {
 struct CRFModelConfig;
 class ModBaseRunner;
 class ModelRunnerBase;
+namespace utils {
+class ChunkCache;
+}  // namespace utils
 
 using Runner = std::shared_ptr<ModelRunnerBase>;
 using PairingParameters = std::variant<ReadOrder, std::map<std::string, std::string>>;
@@ -22,6 +25,7 @@ namespace pipelines {
 /// Create a simplex basecall pipeline description
 /// If source_node_handle is valid, set this to be the source of the simplex pipeline
 /// If sink_node_handle is valid, set this to be the sink of the simplex pipeline
+/// If chunk_cache is set, decoded chunks are looked up in and added to it
 void create_simplex_pipeline(PipelineDescriptor& pipeline_desc,
                              const CRFModelConfig& model_config,
                              std::vector<dorado::Runner>&& runners,
@@ -30,11 +34,14 @@ void create_simplex_pipeline(PipelineDescriptor& pipeline_desc,
                              int scaler_node_threads,
                              int modbase_threads,
                              NodeHandle sink_node_handle = PipelineDescriptor::InvalidNodeHandle,
-                             NodeHandle source_node_handle = PipelineDescriptor::InvalidNodeHandle);
+                             NodeHandle source_node_handle = PipelineDescriptor::InvalidNodeHandle,
+                             std::shared_ptr<const utils::ChunkCache> chunk_cache = nullptr);
 
 /// Create a duplex basecall pipeline description
 /// If source_node_handle is valid, set this to be the source of the simplex pipeline
 /// If sink_node_handle is valid, set this to be the sink of the simplex pipeline
+/// If chunk_cache and stereo_chunk_cache are set, decoded simplex and stereo chunks respectively
+/// are looked up in and added to them
 void create_stereo_duplex_pipeline(
         PipelineDescriptor& pipeline_desc,
         const CRFModelConfig& model_config,
@@ -46,7 +53,9 @@ void create_stereo_duplex_pipeline(
         int splitter_node_threads,
         PairingParameters pairing_parameters,
         NodeHandle sink_node_handle = PipelineDescriptor::InvalidNodeHandle,
-        NodeHandle source_node_handle = PipelineDescriptor::InvalidNodeHandle);
+        NodeHandle source_node_handle = PipelineDescriptor::InvalidNodeHandle,
+        std::shared_ptr<const utils::ChunkCache> chunk_cache = nullptr,
+        std::shared_ptr<const utils::ChunkCache> stereo_chunk_cache = nullptr);
 
 }  // namespace pipelines
 
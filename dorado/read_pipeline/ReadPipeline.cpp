@@ -1,14 +1,18 @@
 #include "ReadPipeline.h"
 
+#include "htslib/hts_endian.h"
 #include "htslib/sam.h"
 #include "utils/base_mod_utils.h"
 #include "utils/sequence_utils.h"
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <charconv>
 #include <chrono>
 #include <iomanip>
-#include <sstream>
 #include <stack>
 
 using namespace std::chrono_literals;
@@ -43,6 +47,15 @@ bool get_modbase_channel_name(std::string &channel_name, const std::string &mod_
     spdlog::error("Unknown modified base abbreviation: {}", mod_abbreviation);
     return false;
 }
+size_t num_decimal_digits(uint32_t value) {
+    size_t digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
 }  // namespace
 
 namespace dorado {
@@ -191,20 +204,19 @@ void Read::generate_modbase_string(bam1_t *aln, uint8_t threshold) const {
 
     const size_t num_channels = base_mod_info->alphabet.size();
     const std::string cardinal_bases = "ACGT";
-    char current_cardinal = 0;
-    if (seq.length() * num_channels != base_mod_probs.size()) {
+    if (base_mod_positions.size() * num_channels != base_mod_probs.size()) {
         throw std::runtime_error(
-                "Mismatch between base_mod_probs size and sequence length * num channels in "
+                "Mismatch between base_mod_probs size and number of positions * num channels in "
                 "modbase_alphabet!");
     }
+    if (!std::is_sorted(base_mod_positions.begin(), base_mod_positions.end()) ||
+        (!base_mod_positions.empty() && base_mod_positions.back() >= seq.length())) {
+        throw std::runtime_error("Invalid base_mod_positions for sequence!");
+    }
 
-    std::istringstream mod_name_stream(base_mod_info->long_names);
-    std::string modbase_string = "";
-    std::vector<uint8_t> modbase_prob;
-
-    // Create a mask indicating which bases are modified.
-    std::map<char, bool> base_has_context = {
-            {'A', false}, {'C', false}, {'G', false}, {'T', false}};
+    // Bases with a context are only called where the context is found, which are the positions
+    // with probabilities.  Other bases are reported if they pass the threshold.
+    std::array<bool, 4> base_has_context = {false, false, false, false};
     utils::BaseModContext context_handler;
     if (!base_mod_info->context.empty()) {
         if (!context_handler.decode(base_mod_info->context)) {
@@ -213,51 +225,114 @@ void Read::generate_modbase_string(bam1_t *aln, uint8_t threshold) const {
         for (auto base : cardinal_bases) {
             if (context_handler.motif(base).size() > 1) {
                 // If the context is just the single base, then this is equivalent to no context.
-                base_has_context[base] = true;
+                base_has_context[utils::base_to_int(base)] = true;
             }
         }
     }
-    auto modbase_mask = context_handler.get_sequence_mask(seq);
-    context_handler.update_mask(modbase_mask, seq, base_mod_info->alphabet, base_mod_probs,
-                                threshold);
 
-    // Iterate over the provided alphabet and find all the channels we need to write out
+    // Find all the channels we need to write out from the provided alphabet.
+    struct ModChannel {
+        size_t channel_idx;
+        char cardinal;
+        std::string bam_name;
+    };
+    std::vector<ModChannel> mod_channels;
+    const auto &long_names = base_mod_info->long_names;
+    size_t name_pos = 0;
+    char current_cardinal = 0;
     for (size_t channel_idx = 0; channel_idx < num_channels; channel_idx++) {
         if (cardinal_bases.find(base_mod_info->alphabet[channel_idx]) != std::string::npos) {
             // A cardinal base
             current_cardinal = base_mod_info->alphabet[channel_idx];
         } else {
             // A modification on the previous cardinal base
-            std::string modbase_name;
-            mod_name_stream >> modbase_name;
+            name_pos = std::min(long_names.find_first_not_of(' ', name_pos), long_names.size());
+            const size_t name_end = std::min(long_names.find(' ', name_pos), long_names.size());
+            const auto modbase_name = long_names.substr(name_pos, name_end - name_pos);
+            name_pos = name_end;
             std::string bam_name;
             if (!get_modbase_channel_name(bam_name, modbase_name)) {
                 return;
             }
+            mod_channels.push_back({channel_idx, current_cardinal, std::move(bam_name)});
+        }
+    }
 
-            // Write out the results we found
-            modbase_string += std::string(1, current_cardinal) + "+" + bam_name;
-            modbase_string += base_has_context[current_cardinal] ? "?" : ".";
-            int skipped_bases = 0;
-            for (size_t base_idx = 0; base_idx < seq.size(); base_idx++) {
-                if (seq[base_idx] == current_cardinal) {
-                    if (modbase_mask[base_idx] == 1) {
-                        modbase_string += "," + std::to_string(skipped_bases);
-                        skipped_bases = 0;
-                        modbase_prob.push_back(
-                                base_mod_probs[base_idx * num_channels + channel_idx]);
-                    } else {
-                        // Skip this base
-                        skipped_bases++;
-                    }
-                }
+    // Calls fn(skipped_bases, prob) for each base reported for the channel, walking
+    // base_mod_positions alongside the sequence.  Bases without a row have zero probability of
+    // modification.
+    const auto for_each_call = [&](const ModChannel &channel, auto &&fn) {
+        const bool has_context = base_has_context[utils::base_to_int(channel.cardinal)];
+        uint32_t skipped_bases = 0;
+        size_t row = 0;
+        for (size_t base_idx = 0; base_idx < seq.size(); base_idx++) {
+            if (seq[base_idx] != channel.cardinal) {
+                continue;
+            }
+            while (row < base_mod_positions.size() && base_mod_positions[row] < base_idx) {
+                row++;
+            }
+            const bool has_row =
+                    row < base_mod_positions.size() && base_mod_positions[row] == base_idx;
+            const uint8_t prob = has_row ? base_mod_probs[row * num_channels + channel.channel_idx]
+                                         : 0;
+            if (has_context ? has_row : prob >= threshold) {
+                fn(skipped_bases, prob);
+                skipped_bases = 0;
+            } else {
+                // Skip this base
+                skipped_bases++;
             }
-            modbase_string += ";";
         }
+    };
+
+    // Size the MM string, e.g. "C+m?,0,12;", and the number of ML values first, so that both
+    // tags can be written straight into the record's aux data with a single allocation.
+    size_t mm_length = 0;
+    uint32_t ml_count = 0;
+    for (const auto &channel : mod_channels) {
+        mm_length += channel.bam_name.size() + 4;
+        for_each_call(channel, [&](uint32_t skipped_bases, uint8_t) {
+            mm_length += 1 + num_decimal_digits(skipped_bases);
+            ml_count++;
+        });
     }
 
-    bam_aux_append(aln, "MM", 'Z', modbase_string.length() + 1, (uint8_t *)modbase_string.c_str());
-    bam_aux_update_array(aln, "ML", 'C', modbase_prob.size(), (uint8_t *)modbase_prob.data());
+    // Type and tag, then the NUL terminated string for MM and the length and values for ML.
+    const size_t mm_size = 3 + mm_length + 1;
+    const size_t ml_size = 4 + sizeof(uint32_t) + ml_count;
+    const size_t new_l_data = size_t(aln->l_data) + mm_size + ml_size;
+    if (new_l_data > aln->m_data && sam_realloc_bam_data(aln, new_l_data) < 0) {
+        throw std::runtime_error("Failed to allocate modified base tags.");
+    }
+
+    char *mm = reinterpret_cast<char *>(aln->data + aln->l_data);
+    uint8_t *ml = aln->data + aln->l_data + mm_size;
+    *mm++ = 'M';
+    *mm++ = 'M';
+    *mm++ = 'Z';
+    *ml++ = 'M';
+    *ml++ = 'L';
+    *ml++ = 'B';
+    *ml++ = 'C';
+    u32_to_le(ml_count, ml);
+    ml += sizeof(uint32_t);
+    for (const auto &channel : mod_channels) {
+        *mm++ = channel.cardinal;
+        *mm++ = '+';
+        mm = std::copy(channel.bam_name.begin(), channel.bam_name.end(), mm);
+        *mm++ = base_has_context[utils::base_to_int(channel.cardinal)] ? '?' : '.';
+        for_each_call(channel, [&](uint32_t skipped_bases, uint8_t prob) {
+            *mm++ = ',';
+            mm = std::to_chars(mm, mm + 10, skipped_bases).ptr;
+            *ml++ = prob;
+        });
+        *mm++ = ';';
+    }
+    *mm++ = '\0';
+    assert(reinterpret_cast<uint8_t *>(mm) == aln->data + aln->l_data + mm_size);
+    assert(ml == aln->data + new_l_data);
+    aln->l_data = int(new_l_data);
 }
 
 float Read::calculate_mean_qscore() const {
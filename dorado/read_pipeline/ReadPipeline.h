@@ -38,6 +38,10 @@ struct Chunk {
     std::string seq;
     std::string qstring;
     std::vector<uint8_t> moves;  // For stitching.
+    // Set in place of qstring if qstring generation is deferred until stitching.
+    std::vector<float> base_error_probs;
+    float q_shift{0.0f};  // Qscore calibration for base_error_probs.
+    float q_scale{1.0f};
 };
 
 // Class representing a read, including raw data
@@ -86,7 +90,12 @@ public:
     std::string seq;                      // Read basecall
     std::string qstring;                  // Read Qstring (Phred)
     std::vector<uint8_t> moves;           // Move table
-    std::vector<uint8_t> base_mod_probs;  // Modified base probabilities
+    // Modified base probabilities are only held for the positions in base_mod_positions, in
+    // ascending order, as a row of one value per modbase alphabet channel for each position.
+    // The positions are the context hits of the modbase models, and every other base is
+    // unmodified.
+    std::vector<uint32_t> base_mod_positions;
+    std::vector<uint8_t> base_mod_probs;
     std::string run_id;                   // Run ID - used in read group
     std::string flowcell_id;              // Flowcell ID - used in read group
     std::string model_name;               // Read group
@@ -9,8 +9,6 @@
 #include <cstring>
 #include <vector>
 
-using namespace torch::indexing;
-
 namespace dorado {
 std::shared_ptr<dorado::Read> StereoDuplexEncoderNode::stereo_encode(
         std::shared_ptr<dorado::Read> template_read,
@@ -36,16 +34,9 @@ std::shared_ptr<dorado::Read> StereoDuplexEncoderNode::stereo_encode(
     const auto complement_sequence_reverse_complement =
             dorado::utils::reverse_complement(complement_read->seq);
 
-    // Align the two reads to one another and print out the score.
-    EdlibAlignConfig align_config = edlibDefaultAlignConfig();
-    align_config.task = EDLIB_TASK_PATH;
-
-    auto temp_strand = template_read->seq.substr(temp_start, temp_end - temp_start);
-    auto comp_strand =
-            complement_sequence_reverse_complement.substr(comp_start, comp_end - comp_start);
-
-    EdlibAlignResult result = edlibAlign(temp_strand.data(), temp_strand.length(),
-                                         comp_strand.data(), comp_strand.length(), align_config);
+    EdlibAlignResult result = dorado::utils::align_duplex_strands(
+            template_read->seq.data() + temp_start, temp_end - temp_start,
+            complement_sequence_reverse_complement.data() + comp_start, comp_end - comp_start);
 
     int target_cursor = temp_start;
     int query_cursor = comp_start;
@@ -59,10 +50,6 @@ std::shared_ptr<dorado::Read> StereoDuplexEncoderNode::stereo_encode(
     static constexpr unsigned char kAlignInsertionToQuery = 2;
     static constexpr unsigned char kAlignMismatch = 3;
 
-    // Move along the alignment, filling out the stereo-encoded tensor
-    const int max_size = template_read->raw_data.size(0) + complement_read->raw_data.size(0);
-    const auto opts = torch::TensorOptions().dtype(torch::kFloat16).device(torch::kCPU);
-
     static constexpr int kNumFeatures = 13;
     // Indices of features in the first dimension of the output tensor.
     static constexpr int kFeatureTemplateSignal = 0;
@@ -72,73 +59,69 @@ std::shared_ptr<dorado::Read> StereoDuplexEncoderNode::stereo_encode(
     static constexpr int kFeatureMoveTable = 10;
     static constexpr int kFeatureTemplateQScore = 11;
     static constexpr int kFeatureComplementQScore = 12;
-    auto tmp = torch::zeros({kNumFeatures, max_size}, opts);
-
-    int template_signal_cursor = 0;
-    int complement_signal_cursor = 0;
-
-    std::vector<uint8_t> template_moves_expanded;
-    for (int i = 0; i < template_read->moves.size(); i++) {
-        template_moves_expanded.push_back(template_read->moves[i]);
-        for (int j = 0; j < m_input_signal_stride - 1; j++) {
-            template_moves_expanded.push_back(0);
-        }
-    }
-
-    int extra_padding = template_read->raw_data.size(0) - template_moves_expanded.size();
-    for (int i = 0; i < extra_padding; i++) {
-        template_moves_expanded.push_back(0);
-    }
 
-    int template_moves_seen = template_moves_expanded[template_signal_cursor];
-    while (template_moves_seen < target_cursor + 1) {
-        template_signal_cursor++;
-        template_moves_seen += template_moves_expanded[template_signal_cursor];
+    // Signal positions of the start of each base, in the order they are aligned, followed by
+    // the end of the last base.  The complement's are positions in its flipped signal, which is
+    // read backwards from the end of the complement's signal rather than materialised.
+    const int template_signal_len = template_read->raw_data.size(0);
+    const auto template_base_starts = dorado::utils::moves_to_map(
+            template_read->moves, m_input_signal_stride, template_signal_len,
+            template_read->seq.length() + 1);
+
+    const int complement_signal_len = complement_read->raw_data.size(0);
+    auto complement_base_starts = dorado::utils::moves_to_map(
+            complement_read->moves, m_input_signal_stride, complement_signal_len,
+            complement_read->seq.length() + 1);
+    std::reverse(complement_base_starts.begin(), complement_base_starts.end());
+    for (auto& base_start : complement_base_starts) {
+        base_start = complement_signal_len - base_start;
     }
 
-    std::vector<uint8_t> complement_moves_expanded;
-    for (int i = 0; i < complement_read->moves.size(); i++) {
-        complement_moves_expanded.push_back(complement_read->moves[i]);
-        for (int j = 0; j < m_input_signal_stride - 1; j++) {
-            complement_moves_expanded.push_back(0);
+    // Each alignment column takes as many samples as the longer of its two bases, so the length
+    // of the encoding is known before anything is written to it.
+    int stereo_signal_len = 0;
+    for (int i = start_alignment_position, template_base = target_cursor,
+             complement_base = query_cursor;
+         i < end_alignment_position; i++) {
+        int template_segment_length = 0;
+        int complement_segment_length = 0;
+        if (result.alignment[i] != kAlignInsertionToQuery) {
+            template_segment_length = template_base_starts[template_base + 1] -
+                                      template_base_starts[template_base];
+            ++template_base;
         }
+        if (result.alignment[i] != kAlignInsertionToTarget) {
+            complement_segment_length = complement_base_starts[complement_base + 1] -
+                                        complement_base_starts[complement_base];
+            ++complement_base;
+        }
+        stereo_signal_len += std::max(template_segment_length, complement_segment_length);
     }
 
-    extra_padding = complement_read->raw_data.size(0) - complement_moves_expanded.size();
-    for (int i = 0; i < extra_padding; i++) {
-        complement_moves_expanded.push_back(0);
-    }
-    complement_moves_expanded.push_back(1);
-    std::reverse(complement_moves_expanded.begin(), complement_moves_expanded.end());
-    complement_moves_expanded.pop_back();
-
-    auto complement_signal = complement_read->raw_data;
-    complement_signal = torch::flip(complement_read->raw_data, 0);
-
-    int complement_moves_seen = complement_read->moves[complement_signal_cursor];
-    while (complement_moves_seen < query_cursor + 1) {
-        complement_signal_cursor++;
-        complement_moves_seen += complement_moves_expanded[complement_signal_cursor];
-    }
-
-    const float pad_value = 0.8 * std::min(torch::min(complement_signal).item<float>(),
-                                           torch::min(template_read->raw_data).item<float>());
+    const auto opts = torch::TensorOptions().dtype(torch::kFloat16).device(torch::kCPU);
+    auto tmp = torch::empty({kNumFeatures, stereo_signal_len}, opts);
 
-    // Start with all signal feature entries equal to the padding value.
-    tmp.index({torch::indexing::Slice(None, 2)}) = pad_value;
+    const float pad_value =
+            0.8 * std::min(torch::min(complement_read->raw_data).item<float>(),
+                           torch::min(template_read->raw_data).item<float>());
 
     // libtorch indexing calls go on a carefree romp through various heap
     // allocations/deallocations and object constructions/destructions, and so are
     // glacially slow.  We therefore work with raw pointers within the main loop.
     const auto* const template_raw_data_ptr =
             static_cast<SampleType*>(template_read->raw_data.data_ptr());
-    const auto* const flipped_complement_raw_data_ptr =
-            static_cast<SampleType*>(complement_signal.data_ptr());
+    const auto* const complement_raw_data_end_ptr =
+            static_cast<SampleType*>(complement_read->raw_data.data_ptr()) + complement_signal_len;
 
     std::array<SampleType*, kNumFeatures> feature_ptrs;
     for (int feature_idx = 0; feature_idx < kNumFeatures; ++feature_idx) {
         auto& feature_ptr = feature_ptrs[feature_idx];
-        feature_ptr = static_cast<SampleType*>(tmp[feature_idx].data_ptr());
+        feature_ptr = static_cast<SampleType*>(tmp.data_ptr()) + feature_idx * stereo_signal_len;
+        // Signal feature entries start as the padding value, and all others as 0.
+        const bool is_signal_feature = feature_idx == kFeatureTemplateSignal ||
+                                       feature_idx == kFeatureComplementSignal;
+        std::fill_n(feature_ptr, stereo_signal_len,
+                    static_cast<SampleType>(is_signal_feature ? pad_value : 0.0f));
     }
 
     int stereo_global_cursor = 0;  // Index into the stereo-encoded signal
@@ -148,60 +131,26 @@ std::shared_ptr<dorado::Read> StereoDuplexEncoderNode::stereo_encode(
         int template_segment_length = 0;    // index into this segment in signal-space
         int complement_segment_length = 0;  // index into this segment in signal-space
 
-        // If there is *not* an insertion to the query, add the nucleotide from the target cursor
+        // If there is *not* an insertion to the query, add the signal of the target base
         if (result.alignment[i] != kAlignInsertionToQuery) {
-            // TODO -- these memcpys could be merged
-            std::memcpy(&feature_ptrs[kFeatureTemplateSignal]
-                                     [stereo_global_cursor + template_segment_length],
-                        &template_raw_data_ptr[template_signal_cursor], sizeof(SampleType));
-            template_segment_length++;
-            template_signal_cursor++;
-            auto max_signal_length = template_moves_expanded.size();
-
-            // We are relying on strings of 0s ended in a 1.  It would be more efficient
-            // in any case to store run length data above.
-            // We're also assuming uint8_t is an alias for char (not guaranteed in principle).
-            const auto* const start_ptr = &template_moves_expanded[template_signal_cursor];
-            auto* const next_move_ptr =
-                    static_cast<const uint8_t*>(std::memchr(start_ptr, 1, max_signal_length));
-            const size_t sample_count =
-                    next_move_ptr ? (next_move_ptr - start_ptr) : max_signal_length;
-
-            // Assumes contiguity of successive elements.
-            std::memcpy(&feature_ptrs[kFeatureTemplateSignal]
-                                     [stereo_global_cursor + template_segment_length],
-                        &template_raw_data_ptr[template_signal_cursor],
-                        sample_count * sizeof(SampleType));
-
-            template_signal_cursor += sample_count;
-            template_segment_length += sample_count;
+            const auto template_signal_start = template_base_starts[target_cursor];
+            template_segment_length =
+                    template_base_starts[target_cursor + 1] - template_signal_start;
+            std::memcpy(&feature_ptrs[kFeatureTemplateSignal][stereo_global_cursor],
+                        &template_raw_data_ptr[template_signal_start],
+                        template_segment_length * sizeof(SampleType));
         }
 
-        // If there is *not* an insertion to the target, add the nucleotide from the query cursor
+        // If there is *not* an insertion to the target, add the signal of the query base
         if (result.alignment[i] != kAlignInsertionToTarget) {
-            std::memcpy(&feature_ptrs[kFeatureComplementSignal]
-                                     [stereo_global_cursor + complement_segment_length],
-                        &flipped_complement_raw_data_ptr[complement_signal_cursor],
-                        sizeof(SampleType));
-
-            complement_segment_length++;
-            complement_signal_cursor++;
-            auto max_signal_length = complement_moves_expanded.size();
-
-            // See comments above.
-            const auto* const start_ptr = &complement_moves_expanded[complement_signal_cursor];
-            auto* const next_move_ptr =
-                    static_cast<const uint8_t*>(std::memchr(start_ptr, 1, max_signal_length));
-            const size_t sample_count =
-                    next_move_ptr ? (next_move_ptr - start_ptr) : max_signal_length;
-
-            std::memcpy(&feature_ptrs[kFeatureComplementSignal]
-                                     [stereo_global_cursor + complement_segment_length],
-                        &flipped_complement_raw_data_ptr[complement_signal_cursor],
-                        sample_count * sizeof(SampleType));
-
-            complement_signal_cursor += sample_count;
-            complement_segment_length += sample_count;
+            const auto complement_signal_start = complement_base_starts[query_cursor];
+            complement_segment_length =
+                    complement_base_starts[query_cursor + 1] - complement_signal_start;
+            // The flipped signal is copied from the complement's signal in reverse.
+            const auto* const segment_end_ptr =
+                    complement_raw_data_end_ptr - complement_signal_start;
+            std::reverse_copy(segment_end_ptr - complement_segment_length, segment_end_ptr,
+                              &feature_ptrs[kFeatureComplementSignal][stereo_global_cursor]);
         }
 
         const int total_segment_length =
@@ -249,9 +198,6 @@ std::shared_ptr<dorado::Read> StereoDuplexEncoderNode::stereo_encode(
         stereo_global_cursor += total_segment_length;
     }
 
-    tmp = tmp.index(
-            {torch::indexing::Slice(None), torch::indexing::Slice(None, stereo_global_cursor)});
-
     read->read_id = template_read->read_id + ";" + complement_read->read_id;
 
     read->attributes.mux = template_read->attributes.mux;
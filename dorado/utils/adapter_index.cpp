@@ -0,0 +1,140 @@
+#include "adapter_index.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace dorado::utils {
+
+AdapterIndex::AdapterIndex(std::string adapter, std::string_view sequence, int max_edist)
+        : m_adapter(std::move(adapter)), m_sequence(sequence), m_max_edist(max_edist) {
+    if (m_adapter.empty() || m_adapter.size() > 64) {
+        throw std::runtime_error("AdapterIndex adapters must be 1 to 64 bases long.");
+    }
+    for (size_t i = 0; i < m_adapter.size(); ++i) {
+        m_char_masks[static_cast<uint8_t>(m_adapter[i])] |= uint64_t(1) << i;
+    }
+
+    scan(0, m_sequence.size(), m_max_edist,
+         [this](uint64_t end_pos, int edist) { m_ends.emplace_back(end_pos, edist); });
+}
+
+template <typename OnEnd>
+void AdapterIndex::scan(uint64_t begin, uint64_t end, int max_edist, OnEnd&& on_end) const {
+    const size_t adapter_len = m_adapter.size();
+    const uint64_t mask = adapter_len == 64 ? ~uint64_t(0) : (uint64_t(1) << adapter_len) - 1;
+    const uint64_t last_bit = uint64_t(1) << (adapter_len - 1);
+
+    // Vertical deltas of the column of edit distances of each adapter prefix, for the alignment
+    // ending at the current position.  The alignment can start anywhere, so the top row is 0.
+    uint64_t pv = mask;
+    uint64_t mv = 0;
+    int edist = int(adapter_len);
+    for (uint64_t pos = begin; pos < end; ++pos) {
+        const uint64_t eq = m_char_masks[static_cast<uint8_t>(m_sequence[pos])];
+        const uint64_t xv = eq | mv;
+        const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & last_bit) {
+            edist++;
+        } else if (mh & last_bit) {
+            edist--;
+        }
+        ph <<= 1;
+        mh <<= 1;
+        pv = (mh | ~(xv | ph)) & mask;
+        mv = ph & xv & mask;
+
+        if (edist <= max_edist) {
+            on_end(pos, edist);
+        }
+    }
+}
+
+std::vector<std::pair<uint64_t, int>> AdapterIndex::match_ends(PosRange subrange, int edist) const {
+    if (edist > m_max_edist) {
+        throw std::runtime_error("AdapterIndex searched beyond its maximum edit distance.");
+    }
+
+    // A match with edit distance at most `edist` spans at most adapter length + edist bases, so
+    // beyond that far into the subrange, matches can't start before it and the index is exact.
+    // Closer to the start of the subrange, the matches are found again within the subrange.
+    const uint64_t indexed_begin =
+            std::min(subrange.second, subrange.first + m_adapter.size() + edist);
+    std::vector<std::pair<uint64_t, int>> ends;
+    scan(subrange.first, indexed_begin, edist,
+         [&ends](uint64_t end_pos, int end_edist) { ends.emplace_back(end_pos, end_edist); });
+
+    auto indexed_it = std::lower_bound(m_ends.begin(), m_ends.end(),
+                                       std::pair<uint64_t, int>(indexed_begin, 0));
+    for (; indexed_it != m_ends.end() && indexed_it->first < subrange.second; ++indexed_it) {
+        if (indexed_it->second <= edist) {
+            ends.push_back(*indexed_it);
+        }
+    }
+    return ends;
+}
+
+uint64_t AdapterIndex::match_start(PosRange subrange, uint64_t end_pos, int edist) const {
+    const size_t adapter_len = m_adapter.size();
+    const uint64_t max_span = adapter_len + edist;
+    const uint64_t window_start =
+            std::max(subrange.first, end_pos + 1 > max_span ? end_pos + 1 - max_span : 0);
+
+    // Global alignment of the adapter to each suffix of [window_start, end_pos], extending the
+    // suffix one base at a time.  column[i] is the edit distance of the last i adapter bases.
+    std::vector<int> column(adapter_len + 1);
+    std::iota(column.begin(), column.end(), 0);
+    uint64_t start = end_pos + 1;
+    for (uint64_t pos = end_pos + 1; pos-- > window_start;) {
+        int diagonal = column[0];
+        column[0]++;
+        for (size_t i = 1; i <= adapter_len; ++i) {
+            const int mismatch = m_adapter[adapter_len - i] != m_sequence[pos];
+            const int cell = std::min({diagonal + mismatch, column[i] + 1, column[i - 1] + 1});
+            diagonal = column[i];
+            column[i] = cell;
+        }
+        if (column[adapter_len] == edist) {
+            start = pos;
+        }
+    }
+    return start;
+}
+
+std::optional<AdapterIndex::Match> AdapterIndex::best_match(PosRange subrange, int edist) const {
+    std::optional<std::pair<uint64_t, int>> best_end;
+    for (const auto& end : match_ends(subrange, edist)) {
+        if (!best_end || end.second < best_end->second) {
+            best_end = end;
+        }
+    }
+    if (!best_end) {
+        return std::nullopt;
+    }
+    const auto [end_pos, end_edist] = *best_end;
+    return Match{{match_start(subrange, end_pos, end_edist), end_pos + 1}, end_edist};
+}
+
+std::vector<AdapterIndex::Match> AdapterIndex::matches(PosRange subrange, int edist) const {
+    const auto ends = match_ends(subrange, edist);
+    std::vector<Match> found;
+    for (size_t cluster_begin = 0; cluster_begin < ends.size();) {
+        auto best_end = ends[cluster_begin];
+        size_t cluster_end = cluster_begin + 1;
+        while (cluster_end < ends.size() &&
+               ends[cluster_end].first < ends[cluster_end - 1].first + m_adapter.size()) {
+            if (ends[cluster_end].second < best_end.second) {
+                best_end = ends[cluster_end];
+            }
+            cluster_end++;
+        }
+        const auto [end_pos, end_edist] = best_end;
+        found.push_back({{match_start(subrange, end_pos, end_edist), end_pos + 1}, end_edist});
+        cluster_begin = cluster_end;
+    }
+    return found;
+}
+
+}  // namespace dorado::utils
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace dorado::utils {
+
+// Approximate occurrences of an adapter in a sequence, found with Myers' bit-parallel edit
+// distance algorithm in a single pass over the sequence.  Searches of any part of the sequence,
+// at any edit distance up to the one the index was built with, then give the same results as an
+// edlib infix (HW) alignment of the adapter to that part, without aligning again.
+// The sequence must outlive the index.  The adapter can be at most 64 bases long.
+class AdapterIndex {
+public:
+    using PosRange = std::pair<uint64_t, uint64_t>;
+
+    struct Match {
+        PosRange range;  // [start, end)
+        int edist;
+    };
+
+    AdapterIndex() = default;
+    AdapterIndex(std::string adapter, std::string_view sequence, int max_edist);
+
+    // The match within `subrange` with the lowest edit distance, the earliest ending of those,
+    // if its edit distance is at most `edist`.
+    std::optional<Match> best_match(PosRange subrange, int edist) const;
+
+    // The matches within `subrange` with edit distance at most `edist`, in order.  Ends of
+    // matches closer together than the adapter length are taken to be the same occurrence, which
+    // is reported once, as its best match.
+    std::vector<Match> matches(PosRange subrange, int edist) const;
+
+private:
+    // Calls `on_end(end_pos, edist)` for each position in [begin, end) at which an alignment of
+    // the adapter starting at or after `begin` ends with edit distance at most `max_edist`.
+    template <typename OnEnd>
+    void scan(uint64_t begin, uint64_t end, int max_edist, OnEnd&& on_end) const;
+
+    // Positions in `subrange` at which a match with edit distance at most `edist` ends.
+    std::vector<std::pair<uint64_t, int>> match_ends(PosRange subrange, int edist) const;
+
+    // Start of the longest alignment within `subrange` of the adapter ending at `end_pos` with
+    // edit distance `edist`, which is the start edlib reports.
+    uint64_t match_start(PosRange subrange, uint64_t end_pos, int edist) const;
+
+    std::string m_adapter;
+    std::string_view m_sequence;
+    int m_max_edist = -1;
+
+    // Bit i is set in the mask of a character if it is adapter base i.
+    std::array<uint64_t, 256> m_char_masks{};
+
+    // Positions at which an alignment of the adapter ends with edit distance at most m_max_edist,
+    // ascending, with the edit distance of the best such alignment.
+    std::vector<std::pair<uint64_t, int>> m_ends;
+};
+
+}  // namespace dorado::utils
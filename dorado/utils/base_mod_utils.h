@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <map>
 #include <string>
 #include <string_view>
@@ -75,10 +76,14 @@ public:
      *  as any such bases should only have their mask values determined by whether the context
      *  is satisfied for that position in the sequence. The threshold is thus ignored for those
      *  bases.
+     *
+     *  The probabilities are given for the ascending modbase_positions only, with a row of one
+     *  value per channel of the modbase alphabet for each, and are zero for every other base.
      */
     void update_mask(std::vector<int>& mask,
                      const std::string& sequence,
                      const std::string& modbase_alphabet,
+                     const std::vector<uint32_t>& modbase_positions,
                      const std::vector<uint8_t>& modbase_probs,
                      uint8_t threshold) const;
 
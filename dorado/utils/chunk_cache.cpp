@@ -0,0 +1,193 @@
+#include "chunk_cache.h"
+
+#include "../decode/fast_hash.h"
+#include "../read_pipeline/ReadPipeline.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr char kEntryMagic[4] = {'D', 'C', 'H', 'K'};
+constexpr uint32_t kEntryVersion = 1;
+// Guards against allocating huge buffers for corrupt entries.
+constexpr uint32_t kMaxFieldSize = 1u << 26;
+
+// Seeds for the two halves of a key.
+constexpr uint64_t kKeySeeds[2] = {0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL};
+
+template <typename T>
+void write_value(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename Container>
+void write_field(std::ostream& out, const Container& field) {
+    write_value(out, uint32_t(field.size()));
+    out.write(reinterpret_cast<const char*>(field.data()),
+              field.size() * sizeof(typename Container::value_type));
+}
+
+template <typename T>
+bool read_value(std::istream& in, T& value) {
+    return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template <typename Container>
+bool read_field(std::istream& in, Container& field) {
+    uint32_t size = 0;
+    if (!read_value(in, size) || size > kMaxFieldSize) {
+        return false;
+    }
+    field.resize(size);
+    return bool(in.read(reinterpret_cast<char*>(field.data()),
+                        size * sizeof(typename Container::value_type)));
+}
+
+// Hashes the device type with the decoder settings, e.g. "cuda:0,1" becomes "cuda/beam_search".
+uint64_t decoder_hash(const std::string& device, const std::string& decoder_id) {
+    const auto id = device.substr(0, device.find(':')) + '/' + decoder_id;
+    return fasthash::fasthash64(id.data(), id.size(), 0);
+}
+
+// Hashes the model's directory name with the name, size and modification time of each file in
+// it, which covers its config as well as its weights, packed or not.
+uint64_t model_hash(const std::filesystem::path& model_path, uint64_t seed) {
+    const auto canonical_path = std::filesystem::canonical(model_path);
+    const auto model_name = canonical_path.filename().string();
+    uint64_t hash = fasthash::fasthash64(model_name.data(), model_name.size(), seed);
+
+    // Directory iteration order is unspecified, so the files are sorted first.
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(canonical_path)) {
+        if (entry.is_regular_file()) {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    for (const auto& file : files) {
+        const auto file_name = file.filename().string();
+        hash = fasthash::fasthash64(file_name.data(), file_name.size(), hash);
+        hash = fasthash::chainfasthash64(hash, uint64_t(std::filesystem::file_size(file)));
+        hash = fasthash::chainfasthash64(
+                hash, uint64_t(std::filesystem::last_write_time(file).time_since_epoch().count()));
+    }
+    return hash;
+}
+
+}  // namespace
+
+namespace dorado::utils {
+
+ChunkCache::ChunkCache(std::filesystem::path dir,
+                       const std::string& device,
+                       const std::string& decoder_id,
+                       const std::filesystem::path& model_path)
+        : m_dir(std::move(dir)), m_seed(model_hash(model_path, decoder_hash(device, decoder_id))) {
+    std::filesystem::create_directories(m_dir);
+}
+
+ChunkCache::Key ChunkCache::key(const torch::Tensor& chunk_input) const {
+    const auto input = chunk_input.contiguous();
+    // The shape and type are folded in so that equal bytes with a different layout differ.
+    uint64_t layout_hash = fasthash::chainfasthash64(m_seed, uint64_t(input.scalar_type()));
+    for (const auto size : input.sizes()) {
+        layout_hash = fasthash::chainfasthash64(layout_hash, uint64_t(size));
+    }
+
+    Key key;
+    for (size_t i = 0; i < key.size(); ++i) {
+        key[i] = fasthash::fasthash64(input.data_ptr(), input.nbytes(), layout_hash ^ kKeySeeds[i]);
+    }
+    return key;
+}
+
+std::filesystem::path ChunkCache::entry_path(const Key& key) const {
+    char name[33];
+    std::snprintf(name, sizeof(name), "%016llx%016llx", static_cast<unsigned long long>(key[0]),
+                  static_cast<unsigned long long>(key[1]));
+    // Entries are spread over 256 subdirectories to keep directory sizes reasonable.
+    return m_dir / std::string(name, 2) / name;
+}
+
+bool ChunkCache::load(const Key& key, Chunk& chunk) const {
+    std::ifstream in(entry_path(key), std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    char magic[sizeof(kEntryMagic)];
+    uint32_t version = 0;
+    Key entry_key{};
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), kEntryMagic) ||
+        !read_value(in, version) || version != kEntryVersion || !read_value(in, entry_key) ||
+        entry_key != key) {
+        return false;
+    }
+
+    std::string seq, qstring;
+    std::vector<uint8_t> moves;
+    std::vector<float> base_error_probs;
+    float q_shift = 0.0f, q_scale = 1.0f;
+    if (!read_field(in, seq) || !read_field(in, qstring) || !read_field(in, moves) ||
+        !read_field(in, base_error_probs) || !read_value(in, q_shift) ||
+        !read_value(in, q_scale)) {
+        spdlog::debug("Ignoring truncated chunk cache entry {}", entry_path(key).string());
+        return false;
+    }
+
+    chunk.seq = std::move(seq);
+    chunk.qstring = std::move(qstring);
+    chunk.moves = std::move(moves);
+    chunk.base_error_probs = std::move(base_error_probs);
+    chunk.q_shift = q_shift;
+    chunk.q_scale = q_scale;
+    return true;
+}
+
+void ChunkCache::store(const Key& key, const Chunk& chunk) const {
+    static std::atomic<uint64_t> temp_file_count{0};
+
+    const auto path = entry_path(key);
+    // Unique among the threads of this process, and in practice between processes.
+    std::ostringstream temp_name;
+    temp_name << path.filename().string() << ".tmp" << std::this_thread::get_id() << '_'
+              << temp_file_count++ << '_'
+              << std::chrono::steady_clock::now().time_since_epoch().count();
+    const auto temp_path = path.parent_path() / temp_name.str();
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    {
+        std::ofstream out(temp_path, std::ios::binary);
+        out.write(kEntryMagic, sizeof(kEntryMagic));
+        write_value(out, kEntryVersion);
+        write_value(out, key);
+        write_field(out, chunk.seq);
+        write_field(out, chunk.qstring);
+        write_field(out, chunk.moves);
+        write_field(out, chunk.base_error_probs);
+        write_value(out, chunk.q_shift);
+        write_value(out, chunk.q_scale);
+        if (!out.flush()) {
+            error = std::make_error_code(std::errc::io_error);
+        }
+    }
+    if (!error) {
+        std::filesystem::rename(temp_path, path, error);
+    }
+    if (error) {
+        spdlog::debug("Failed to write chunk cache entry {}: {}", path.string(), error.message());
+        std::filesystem::remove(temp_path, error);
+    }
+}
+
+}  // namespace dorado::utils
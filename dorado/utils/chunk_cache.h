@@ -0,0 +1,51 @@
+#pragma once
+
+#include <torch/torch.h>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace dorado {
+struct Chunk;
+}  // namespace dorado
+
+namespace dorado::utils {
+
+// On-disk, content-addressed cache of decoded chunks, keyed by the model and a hash of each
+// chunk's input signal, so that interrupted or repeated runs don't recompute identical chunks.
+// Entries are written to a temporary file and renamed into place, so several processes can share
+// a cache directory.  Results are assumed not to depend on the batch size, nor on which device of
+// a given type they were computed on.
+class ChunkCache {
+public:
+    using Key = std::array<uint64_t, 2>;
+
+    // The type of `device` ("cpu", "cuda", "metal") is part of every key, as it decides both the
+    // numerics and whether chunks carry a qstring or per-base error probabilities.
+    // `decoder_id` distinguishes decoder settings which change the output of a given model.
+    // The model is identified by its directory name and the names, sizes and modification times
+    // of the files in it, so entries are not reused once its weights change.
+    ChunkCache(std::filesystem::path dir,
+               const std::string& device,
+               const std::string& decoder_id,
+               const std::filesystem::path& model_path);
+
+    Key key(const torch::Tensor& chunk_input) const;
+
+    // Fills in the decoded sequence, qstring or error probabilities, and moves of `chunk` from
+    // the entry for `key`.  Returns false if there is no valid entry.
+    bool load(const Key& key, Chunk& chunk) const;
+    // Failing to write an entry is logged rather than thrown, as the cache is only a shortcut.
+    void store(const Key& key, const Chunk& chunk) const;
+
+private:
+    std::filesystem::path entry_path(const Key& key) const;
+
+    std::filesystem::path m_dir;
+    // Hash of the device type, decoder settings and model files, which seeds every key.
+    uint64_t m_seed;
+};
+
+}  // namespace dorado::utils
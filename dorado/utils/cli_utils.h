@@ -12,6 +12,7 @@
 #include <cmath>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
@@ -77,6 +78,16 @@ inline argparse::ArgumentParser parse_internal_options(
             .help("(WARNING: For expert users only) Skip model and data compatibility checks.")
             .default_value(false)
             .implicit_value(true);
+    private_parser.add_argument("--viterbi")
+            .help("(WARNING: For expert users only) Decode the single best path rather than "
+                  "beam searching. Faster but less accurate, CPU only.")
+            .default_value(false)
+            .implicit_value(true);
+    private_parser.add_argument("--cpu-decode-threads")
+            .help("(WARNING: For expert users only) Number of threads decoding CPU basecalls, "
+                  "shared by all CPU runners. 0 for one per CPU runner.")
+            .default_value(0)
+            .scan<'i', int>();
     private_parser.add_argument("--dump_stats_file")
             .help("Internal processing stats. output filename.")
             .default_value(std::string(""));
@@ -86,6 +97,10 @@ inline argparse::ArgumentParser parse_internal_options(
     args.insert(args.begin(), prog_name);
     private_parser.parse_args(args);
 
+    if (private_parser.get<int>("--cpu-decode-threads") < 0) {
+        throw std::runtime_error("--cpu-decode-threads must be at least 0.");
+    }
+
     return private_parser;
 }
 
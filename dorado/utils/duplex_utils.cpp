@@ -1,8 +1,7 @@
 #include "duplex_utils.h"
 
-#include <torch/torch.h>
-
 #include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <vector>
 
@@ -105,15 +104,46 @@ std::pair<std::pair<int, int>, std::pair<int, int>> get_trimmed_alignment(
     return std::make_pair(alignment_start_end, query_target_cursors);
 }
 
+EdlibAlignResult align_duplex_strands(const char* template_strand,
+                                      int template_len,
+                                      const char* complement_strand,
+                                      int complement_len) {
+    // Upper bound on the edit distance per base between the two strands of a molecule.
+    const float kMaxStrandErrorRate = 0.1f;
+
+    EdlibAlignConfig align_config = edlibDefaultAlignConfig();
+    align_config.task = EDLIB_TASK_PATH;
+    align_config.k = std::abs(template_len - complement_len) +
+                     int(kMaxStrandErrorRate * std::max(template_len, complement_len));
+
+    EdlibAlignResult result = edlibAlign(template_strand, template_len, complement_strand,
+                                         complement_len, align_config);
+    if (result.status == EDLIB_STATUS_OK && result.editDistance >= 0) {
+        return result;
+    }
+    edlibFreeAlignResult(result);
+    align_config.k = -1;
+    return edlibAlign(template_strand, template_len, complement_strand, complement_len,
+                      align_config);
+}
+
 // Applies a min pool filter to q scores for basespace-duplex algorithm
-void preprocess_quality_scores(std::vector<uint8_t>& quality_scores, int pool_window) {
-    // Apply a min-pool window to the quality scores
-    auto opts = torch::TensorOptions().dtype(torch::kInt8);
-    torch::Tensor t =
-            torch::from_blob(quality_scores.data(), {1, (int)quality_scores.size()}, opts);
-    auto t_float = t.to(torch::kFloat32);
-    t.index({torch::indexing::Slice()}) =
-            -torch::max_pool1d(-t_float, pool_window, 1, pool_window / 2);
+std::vector<uint8_t> preprocess_quality_scores(std::string_view qstring,
+                                               bool reverse,
+                                               int pool_window) {
+    // Apply a min-pool window to the quality scores, read straight from the qstring.  Windows are
+    // truncated at the ends, as with padding by the largest score.  The window is symmetric, so
+    // pooling and then reversing gives the same scores as reversing and then pooling.
+    const int len = int(qstring.size());
+    const int half_window = pool_window / 2;
+    std::vector<uint8_t> quality_scores(len);
+    for (int i = 0; i < len; ++i) {
+        const auto window_begin = qstring.begin() + std::max(0, i - half_window);
+        const auto window_end = qstring.begin() + std::min(len, i + half_window + 1);
+        quality_scores[reverse ? len - 1 - i : i] =
+                uint8_t(*std::min_element(window_begin, window_end));
+    }
+    return quality_scores;
 }
 
 const std::string get_stereo_model_name(const std::string& simplex_model_name,
@@ -1,9 +1,12 @@
 #pragma once
 
+#include "3rdparty/edlib/edlib/include/edlib.h"
+
 #include <iostream>
 #include <map>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include <vector>
 
@@ -22,8 +25,24 @@ std::pair<std::pair<int, int>, std::pair<int, int>> get_trimmed_alignment(
         int start_alignment_position,
         int end_alignment_position);
 
-// Applies a min pool filter to q scores for basespace-duplex algorithm
-void preprocess_quality_scores(std::vector<uint8_t>& quality_scores, int pool_window = 5);
+// Globally aligns the template strand of a duplex pair to the reverse complement of the complement
+// strand, with the template as the edlib query.  The two strands are nearly the same sequence, so
+// edlib is first given a limit k on the edit distance, from their length difference and an upper
+// bound on their error rate.  Without a limit, edlib starts from a small k and doubles it until an
+// alignment is found, which takes several attempts on long reads.  If the strands are further
+// apart than the limit, the alignment is rerun without one.  The result must be freed with
+// edlibFreeAlignResult.
+EdlibAlignResult align_duplex_strands(const char* template_strand,
+                                      int template_len,
+                                      const char* complement_strand,
+                                      int complement_len);
+
+// Applies a min pool filter to the q scores of `qstring` for basespace-duplex algorithm, returning
+// them in reverse order if `reverse` is set.  The window is centred on each score, so should be
+// odd.
+std::vector<uint8_t> preprocess_quality_scores(std::string_view qstring,
+                                               bool reverse = false,
+                                               int pool_window = 5);
 
 std::unordered_set<std::string> get_read_list_from_pairs(
         std::map<std::string, std::string> template_complement_map);
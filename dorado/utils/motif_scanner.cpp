@@ -0,0 +1,113 @@
+#include "motif_scanner.h"
+
+#include <stdexcept>
+
+namespace {
+
+// 2-bit codes of the bases ACGT, or -1 for anything else.
+constexpr std::array<int8_t, 256> kBaseCodes = [] {
+    std::array<int8_t, 256> codes{};
+    for (auto& code : codes) {
+        code = -1;
+    }
+    codes['A'] = 0;
+    codes['C'] = 1;
+    codes['G'] = 2;
+    codes['T'] = 3;
+    return codes;
+}();
+
+// The bases each IUPAC code in a motif stands for, as a bit per 2-bit base code, or 0 for
+// anything else.
+constexpr std::array<uint8_t, 256> kMotifBaseSets = [] {
+    constexpr uint8_t A = 1, C = 2, G = 4, T = 8;
+    std::array<uint8_t, 256> sets{};
+    sets['A'] = A;
+    sets['C'] = C;
+    sets['G'] = G;
+    sets['T'] = T;
+    sets['R'] = A | G;
+    sets['Y'] = C | T;
+    sets['S'] = C | G;
+    sets['W'] = A | T;
+    sets['K'] = G | T;
+    sets['M'] = A | C;
+    sets['B'] = C | G | T;
+    sets['D'] = A | G | T;
+    sets['H'] = A | C | T;
+    sets['V'] = A | C | G;
+    sets['N'] = A | C | G | T;
+    return sets;
+}();
+
+}  // namespace
+
+namespace dorado::utils {
+
+MotifScanner::MotifScanner(const std::vector<std::string>& motifs,
+                           const std::vector<size_t>& offsets)
+        : m_offsets(offsets) {
+    if (motifs.size() != offsets.size()) {
+        throw std::runtime_error("MotifScanner needs an offset for every motif.");
+    }
+
+    size_t bit = 0;
+    for (size_t motif_idx = 0; motif_idx < motifs.size(); ++motif_idx) {
+        const auto& motif = motifs[motif_idx];
+        m_lengths.push_back(motif.size());
+        m_last_bit.push_back(0);
+        if (motif.empty()) {
+            // Never matches.
+            continue;
+        }
+        if (offsets[motif_idx] >= motif.size()) {
+            throw std::runtime_error("Motif offset is outside of motif " + motif);
+        }
+        if (bit + motif.size() > 64) {
+            throw std::runtime_error("Motifs are too long to scan for together.");
+        }
+        m_first_bits |= uint64_t(1) << bit;
+        for (auto base : motif) {
+            // A position of the motif matches each base its code stands for.
+            const auto base_set = kMotifBaseSets[uint8_t(base)];
+            if (base_set == 0) {
+                throw std::runtime_error("Invalid base in motif " + motif);
+            }
+            for (size_t code = 0; code < m_base_masks.size(); ++code) {
+                if (base_set & (1 << code)) {
+                    m_base_masks[code] |= uint64_t(1) << bit;
+                }
+            }
+            ++bit;
+        }
+        m_last_bit.back() = uint64_t(1) << (bit - 1);
+        m_last_bits |= m_last_bit.back();
+    }
+}
+
+std::vector<std::vector<uint32_t>> MotifScanner::scan(std::string_view sequence) const {
+    std::vector<std::vector<uint32_t>> hits(m_lengths.size());
+    // Bit i of the state is set if the bases of its motif up to and including bit i match the
+    // sequence ending at the current position.
+    uint64_t state = 0;
+    for (size_t pos = 0; pos < sequence.size(); ++pos) {
+        const auto code = kBaseCodes[uint8_t(sequence[pos])];
+        if (code < 0) {
+            state = 0;
+            continue;
+        }
+        state = ((state << 1) | m_first_bits) & m_base_masks[code];
+        if ((state & m_last_bits) == 0) {
+            continue;
+        }
+        for (size_t motif_idx = 0; motif_idx < m_last_bit.size(); ++motif_idx) {
+            if (state & m_last_bit[motif_idx]) {
+                hits[motif_idx].push_back(
+                        uint32_t(pos + 1 - m_lengths[motif_idx] + m_offsets[motif_idx]));
+            }
+        }
+    }
+    return hits;
+}
+
+}  // namespace dorado::utils
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dorado::utils {
+
+// Finds the occurrences of several motifs in a sequence with a single pass over it.
+// The motifs are matched together with the bit-parallel shift-and algorithm, each motif taking
+// as many bits of one 64-bit state word as it has bases, so a step of the scan advances every
+// motif at once.  Motifs are made of the bases ACGT and IUPAC codes such as R (A or G), which
+// set the bit of a position in the mask of every base they stand for.  Together the motifs can
+// be at most 64 bases long.
+class MotifScanner {
+public:
+    MotifScanner() = default;
+    // `offsets` gives the position of the base of interest within each motif.
+    MotifScanner(const std::vector<std::string>& motifs, const std::vector<size_t>& offsets);
+
+    size_t num_motifs() const { return m_lengths.size(); }
+
+    // For each motif, the ascending positions in `sequence` of the base of interest in every
+    // occurrence of the motif.  Occurrences may overlap.  Bases other than ACGT never match.
+    std::vector<std::vector<uint32_t>> scan(std::string_view sequence) const;
+
+private:
+    // Bit i is set in the mask of a base if bit i of the state corresponds to a motif position
+    // which that base matches.
+    std::array<uint64_t, 4> m_base_masks{};
+    // The bits of the first and last bases of each motif.
+    uint64_t m_first_bits = 0;
+    uint64_t m_last_bits = 0;
+    // The bit of the last base of each motif, or 0 for empty motifs.
+    std::vector<uint64_t> m_last_bit;
+    std::vector<size_t> m_lengths;
+    std::vector<size_t> m_offsets;
+};
+
+}  // namespace dorado::utils
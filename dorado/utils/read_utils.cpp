@@ -26,6 +26,7 @@ std::shared_ptr<Read> shallow_copy_read(const Read& read) {
     copy->run_id = read.run_id;
     copy->model_name = read.model_name;
 
+    copy->base_mod_positions = read.base_mod_positions;
     copy->base_mod_probs = read.base_mod_probs;
     copy->base_mod_info = read.base_mod_info;
 
@@ -8,6 +8,7 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstring>
 #include <iterator>
 #include <numeric>
 #include <vector>
@@ -126,10 +127,95 @@ __attribute__((target("avx2"))) std::string reverse_complement_impl(const std::s
 }
 #endif
 
+// Q string characters are '!' + 0.5 + the clamped qscore, truncated, so lie in this range.
+constexpr char kMinQChar = 34;
+constexpr char kMaxQChar = 83;
+constexpr size_t kNumQCharThresholds = kMaxQChar - kMinQChar;
+
+// An error probability p gets at least Q string character c if p <= thresholds[c - kMinQChar - 1].
+// Comparing against these avoids evaluating a log per base.  Thresholds decrease with c.
+std::array<float, kNumQCharThresholds> qchar_thresholds(float shift, float scale) {
+    std::array<float, kNumQCharThresholds> thresholds;
+    for (size_t i = 0; i < kNumQCharThresholds; ++i) {
+        // The qscore at which the character reaches kMinQChar + i + 1, as an error probability.
+        const double min_qscore = double(kMinQChar + int(i) + 1) - 33.5;
+        thresholds[i] = float(std::pow(10.0, -(min_qscore - shift) / (10.0 * scale)));
+    }
+    return thresholds;
+}
+
+// NaN error probabilities compare as not greater than every threshold, giving the maximum
+// qscore, as the clamping of a NaN qscore used to.
+#if ENABLE_AVX2_IMPL
+__attribute__((target("default")))
+#endif
+void qchars_from_error_probs(const float* const error_probs,
+                             size_t num_bases,
+                             const std::array<float, kNumQCharThresholds>& thresholds,
+                             char* const qchars) {
+    for (size_t i = 0; i < num_bases; ++i) {
+        const float p = error_probs[i];
+        char qchar = kMinQChar;
+        for (const float threshold : thresholds) {
+            qchar += !(p > threshold);
+        }
+        qchars[i] = qchar;
+    }
+}
+
+#if ENABLE_AVX2_IMPL
+__attribute__((target("avx2"))) void qchars_from_error_probs(
+        const float* const error_probs,
+        size_t num_bases,
+        const std::array<float, kNumQCharThresholds>& thresholds,
+        char* const qchars) {
+    // Gathers the low byte of each 32 bit lane into the bottom 8 bytes.
+    const __m256i kLowBytes = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                               -1, -1, 0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1,
+                                               -1, -1, -1, -1);
+    size_t i = 0;
+    for (; i + 8 <= num_bases; i += 8) {
+        const __m256 p = _mm256_loadu_ps(error_probs + i);
+        __m256i qchar = _mm256_set1_epi32(kMinQChar);
+        for (const float threshold : thresholds) {
+            // Lanes where p is not greater than the threshold are all ones, i.e. -1.
+            const __m256 not_greater = _mm256_cmp_ps(p, _mm256_set1_ps(threshold), _CMP_NGT_UQ);
+            qchar = _mm256_sub_epi32(qchar, _mm256_castps_si256(not_greater));
+        }
+        const __m256i packed = _mm256_shuffle_epi8(qchar, kLowBytes);
+        const uint32_t lo = uint32_t(_mm256_extract_epi32(packed, 0));
+        const uint32_t hi = uint32_t(_mm256_extract_epi32(packed, 4));
+        std::memcpy(qchars + i, &lo, sizeof(lo));
+        std::memcpy(qchars + i + 4, &hi, sizeof(hi));
+    }
+    for (; i < num_bases; ++i) {
+        const float p = error_probs[i];
+        char qchar = kMinQChar;
+        for (const float threshold : thresholds) {
+            qchar += !(p > threshold);
+        }
+        qchars[i] = qchar;
+    }
+}
+#endif
+
 }  // namespace
 
 namespace dorado::utils {
 
+std::string qstring_from_error_probs(const float* const error_probs,
+                                     size_t num_bases,
+                                     float shift,
+                                     float scale) {
+    std::string qstring(num_bases, '!');
+    if (num_bases == 0) {
+        return qstring;
+    }
+    const auto thresholds = qchar_thresholds(shift, scale);
+    qchars_from_error_probs(error_probs, num_bases, thresholds, qstring.data());
+    return qstring;
+}
+
 float mean_qscore_from_qstring(const std::string& qstring, int start_pos) {
     if (qstring.empty()) {
         return 0.0f;
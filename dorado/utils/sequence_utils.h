@@ -9,6 +9,13 @@ namespace dorado::utils {
 // Calculate a mean qscore from a per-base Q string.
 float mean_qscore_from_qstring(const std::string& qstring, int start_pos = 0);
 
+// Convert per-base error probabilities to a Phred+33 Q string.  Qscores are calibrated as
+// qscore * scale + shift, then clamped to [1, 50].  `scale` must be positive.
+std::string qstring_from_error_probs(const float* error_probs,
+                                     size_t num_bases,
+                                     float shift,
+                                     float scale);
+
 // Convert a canonical base character (ACGT) to an integer representation (0123).
 // No checking is performed on the input.
 inline int base_to_int(char c) { return 0b11 & ((c >> 2) ^ (c >> 1)); }
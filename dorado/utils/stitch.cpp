@@ -1,5 +1,10 @@
 #include "../read_pipeline/ReadPipeline.h"
 #include "math_utils.h"
+#include "sequence_utils.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
 
 namespace dorado::utils {
 
@@ -11,8 +16,24 @@ void stitch_chunks(std::shared_ptr<Read> read) {
     int start_pos = 0;
     int mid_point_front = 0;
     std::vector<uint8_t> moves;
-    std::vector<std::string> sequences;
-    std::vector<std::string> qstrings;
+    std::string seq;
+    std::string qstring;
+
+    // Appends up to `len` bases of `chunk` from `pos` with their qstring.  Chunks may carry
+    // per-base error probabilities instead, which are converted here so that no work is spent on
+    // the bases trimmed from the overlaps.  Each chunk is handled on its own, as a read can mix
+    // freshly called chunks with ones loaded from a cache.
+    auto append_bases = [&](const Chunk& chunk, size_t pos, size_t len = std::string::npos) {
+        pos = std::min(pos, chunk.seq.size());
+        len = std::min(len, chunk.seq.size() - pos);
+        seq.append(chunk.seq, pos, len);
+        if (!chunk.base_error_probs.empty()) {
+            qstring += qstring_from_error_probs(chunk.base_error_probs.data() + pos, len,
+                                                chunk.q_shift, chunk.q_scale);
+        } else {
+            qstring.append(chunk.qstring, pos, len);
+        }
+    };
 
     for (int i = 0; i < read->num_chunks - 1; i++) {
         auto current_chunk = read->called_chunks[i];
@@ -30,8 +51,7 @@ void stitch_chunks(std::shared_ptr<Read> read) {
         int current_chunk_seq_len = current_chunk->seq.size();
         int end_pos = current_chunk_seq_len - current_chunk_bases_to_trim;
         int trimmed_len = end_pos - start_pos;
-        sequences.push_back(current_chunk->seq.substr(start_pos, trimmed_len));
-        qstrings.push_back(current_chunk->qstring.substr(start_pos, trimmed_len));
+        append_bases(*current_chunk, start_pos, trimmed_len);
         moves.insert(moves.end(), std::next(current_chunk->moves.begin(), mid_point_front),
                      std::prev(current_chunk->moves.end(), mid_point_rear));
 
@@ -53,17 +73,15 @@ void stitch_chunks(std::shared_ptr<Read> read) {
         int last_index_in_moves_to_keep = read->raw_data.size(0) / read->model_stride;
         moves = std::vector<uint8_t>(moves.begin(), moves.begin() + last_index_in_moves_to_keep);
         int end = std::accumulate(moves.begin(), moves.end(), 0);
-        sequences.push_back(last_chunk->seq.substr(start_pos, end));
-        qstrings.push_back(last_chunk->qstring.substr(start_pos, end));
+        append_bases(*last_chunk, start_pos, end);
 
     } else {
-        sequences.push_back(last_chunk->seq.substr(start_pos));
-        qstrings.push_back(last_chunk->qstring.substr(start_pos));
+        append_bases(*last_chunk, start_pos);
     }
 
     // Set the read seq and qstring
-    read->seq = std::accumulate(sequences.begin(), sequences.end(), std::string(""));
-    read->qstring = std::accumulate(qstrings.begin(), qstrings.end(), std::string(""));
+    read->seq = std::move(seq);
+    read->qstring = std::move(qstring);
     read->moves = std::move(moves);
 
     // remove partial stride overhang
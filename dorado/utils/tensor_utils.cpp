@@ -1,13 +1,35 @@
 #include "tensor_utils.h"
 
+#include "cxxpool.h"
+#include "math_utils.h"
 #include "simd.h"
 
 #include <torch/csrc/jit/serialization/pickle.h>
 #include <torch/torch.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <fstream>
+#include <future>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -63,6 +85,204 @@ __attribute__((target("avx2,f16c"))) void convert_f32_to_f16_impl(c10::Half* con
 }
 #endif
 
+// Packed tensor file layout (native endianness):
+//   char[8]   magic
+//   uint32_t  version
+//   uint32_t  number of tensors
+//   per tensor:
+//     uint32_t  name length, followed by the name
+//     int32_t   torch::ScalarType
+//     uint32_t  number of dimensions, followed by that many int64_t sizes
+//     uint64_t  offset of the data from the start of the file (multiple of kPackedAlignment)
+//     uint64_t  size of the data in bytes
+//     uint64_t  size of the source .tensor file
+//     int64_t   modification time of the source .tensor file
+//   tensor data
+constexpr char kPackedMagic[8] = {'D', 'O', 'R', 'A', 'D', 'O', 'P', 'T'};
+constexpr uint32_t kPackedVersion = 2;
+constexpr uint64_t kPackedAlignment = 64;
+
+// Size and modification time of a source .tensor file, used to tell whether a packed file is
+// still up to date.
+using SourceStamp = std::pair<uint64_t, int64_t>;
+
+SourceStamp source_stamp(const std::filesystem::path& path) {
+    const auto mtime = std::filesystem::last_write_time(path).time_since_epoch();
+    return {std::filesystem::file_size(path), static_cast<int64_t>(mtime.count())};
+}
+
+// The serialised .tensor files in `dir`, sorted by name.
+std::vector<std::filesystem::path> tensor_files(const std::filesystem::path& dir) {
+    std::vector<std::filesystem::path> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".tensor") {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// Read-only view of a file's contents.  On POSIX systems the file is memory-mapped privately,
+// so pages are shared with the page cache and any write to a tensor is copy-on-write.
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path) {
+#ifndef _WIN32
+        const int fd = open(path.string().c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("Failed to stat " + path.string());
+        }
+        m_size = static_cast<size_t>(st.st_size);
+        void* addr = m_size ? mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0)
+                            : MAP_FAILED;
+        close(fd);
+        if (addr == MAP_FAILED) {
+            throw std::runtime_error("Failed to map " + path.string());
+        }
+        m_data = static_cast<std::byte*>(addr);
+#else
+        std::ifstream fin(path, std::ios::binary);
+        if (!fin) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+        // Over-allocate so that the data can start on an aligned boundary, as it would if mapped.
+        m_size = std::filesystem::file_size(path);
+        m_buffer.resize(m_size + kPackedAlignment);
+        void* aligned = m_buffer.data();
+        size_t space = m_buffer.size();
+        m_data = static_cast<std::byte*>(std::align(kPackedAlignment, m_size, aligned, space));
+        fin.read(reinterpret_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        munmap(m_data, m_size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::byte* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    std::byte* m_data{nullptr};
+    size_t m_size{0};
+#ifdef _WIN32
+    std::vector<std::byte> m_buffer;
+#endif
+};
+
+class PackedReader {
+public:
+    PackedReader(const std::byte* data, size_t size) : m_data(data), m_size(size) {}
+
+    template <typename T>
+    T read() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    std::string read_string(size_t length) {
+        const auto* ptr = take(length);
+        return std::string(reinterpret_cast<const char*>(ptr), length);
+    }
+
+private:
+    const std::byte* take(size_t count) {
+        if (count > m_size - m_pos) {
+            throw std::runtime_error("Truncated packed tensor file header.");
+        }
+        const auto* ptr = m_data + m_pos;
+        m_pos += count;
+        return ptr;
+    }
+
+    const std::byte* m_data;
+    size_t m_size;
+    size_t m_pos{0};
+};
+
+// Maps the packed file and returns tensors, indexed by name, which view its contents.
+// Returns nullopt if the packed file was written by another version, or if the .tensor files
+// alongside it have changed since it was written.
+std::optional<std::unordered_map<std::string, torch::Tensor>> load_packed_tensors(
+        const std::filesystem::path& path) {
+    auto file = std::make_shared<MappedFile>(path);
+    PackedReader reader(file->data(), file->size());
+
+    char magic[sizeof(kPackedMagic)];
+    for (auto& c : magic) {
+        c = reader.read<char>();
+    }
+    if (std::memcmp(magic, kPackedMagic, sizeof(kPackedMagic)) != 0) {
+        throw std::runtime_error(path.string() + " is not a packed tensor file.");
+    }
+    const auto version = reader.read<uint32_t>();
+    if (version != kPackedVersion) {
+        spdlog::debug("Ignoring {}, which has packed tensor file version {}", path.string(),
+                      version);
+        return std::nullopt;
+    }
+
+    std::unordered_map<std::string, torch::Tensor> tensors;
+    std::unordered_map<std::string, SourceStamp> source_stamps;
+    const auto num_tensors = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < num_tensors; ++i) {
+        const auto name = reader.read_string(reader.read<uint32_t>());
+        const auto dtype = static_cast<torch::ScalarType>(reader.read<int32_t>());
+        const auto num_dims = reader.read<uint32_t>();
+        if (num_dims > 64) {
+            throw std::runtime_error("Corrupt packed tensor file " + path.string());
+        }
+        std::vector<int64_t> sizes(num_dims);
+        for (auto& size : sizes) {
+            size = reader.read<int64_t>();
+        }
+        const auto offset = reader.read<uint64_t>();
+        const auto nbytes = reader.read<uint64_t>();
+        const auto source_size = reader.read<uint64_t>();
+        const auto source_mtime = reader.read<int64_t>();
+        source_stamps.emplace(name, SourceStamp{source_size, source_mtime});
+        if (offset > file->size() || nbytes > file->size() - offset) {
+            throw std::runtime_error("Tensor " + name + " lies outside " + path.string());
+        }
+
+        // The tensor keeps the mapping alive for as long as it (or any view of it) exists.
+        auto tensor = torch::from_blob(
+                file->data() + offset, sizes, [file](void*) {},
+                torch::TensorOptions().dtype(dtype));
+        if (size_t(tensor.nbytes()) != nbytes) {
+            throw std::runtime_error("Size mismatch for tensor " + name + " in " + path.string());
+        }
+        tensors.emplace(name, std::move(tensor));
+    }
+
+    // The packed file is only used if it holds exactly the current .tensor files.
+    const auto sources = tensor_files(path.parent_path());
+    if (sources.size() != source_stamps.size() ||
+        !std::all_of(sources.begin(), sources.end(), [&source_stamps](const auto& source) {
+            auto it = source_stamps.find(source.filename().string());
+            return it != source_stamps.end() && it->second == source_stamp(source);
+        })) {
+        spdlog::warn("{} is out of date, loading the .tensor files instead. Run 'dorado pack' to "
+                     "update it.",
+                     path.string());
+        return std::nullopt;
+    }
+
+    return tensors;
+}
+
 }  // namespace
 
 namespace dorado::utils {
@@ -76,15 +296,128 @@ void serialise_tensor(torch::Tensor t, const std::string& path) {
 
 std::vector<torch::Tensor> load_tensors(const std::filesystem::path& dir,
                                         const std::vector<std::string>& tensors) {
+    const auto packed_path = dir / kPackedTensorsFilename;
+    std::optional<std::unordered_map<std::string, torch::Tensor>> packed;
+    if (std::filesystem::exists(packed_path)) {
+        packed = load_packed_tensors(packed_path);
+    }
+    if (packed) {
+        std::vector<torch::Tensor> weights;
+        weights.reserve(tensors.size());
+        for (const auto& tensor : tensors) {
+            auto it = packed->find(tensor);
+            if (it == packed->end()) {
+                throw std::runtime_error("Tensor " + tensor + " not found in " +
+                                         packed_path.string());
+            }
+            weights.push_back(it->second);
+        }
+        return weights;
+    }
+
+    // Each file is deserialised independently, so load them in parallel and then
+    // gather the results in the order requested.  Models are loaded concurrently (e.g. one per
+    // CUDA device), so all loads share one pool rather than each starting a pool of its own.
+    static cxxpool::thread_pool pool{
+            std::max(size_t(1), size_t(std::thread::hardware_concurrency()))};
+    std::vector<std::future<std::vector<torch::Tensor>>> futures;
+    futures.reserve(tensors.size());
+    for (const auto& tensor : tensors) {
+        futures.push_back(pool.push([path = dir / tensor] {
+            std::vector<torch::Tensor> loaded;
+            torch::load(loaded, path.string());
+            return loaded;
+        }));
+    }
+
     auto weights = std::vector<torch::Tensor>();
-    for (auto tensor : tensors) {
-        auto path = dir / tensor;
-        torch::load(weights, path.string());
+    for (auto& future : futures) {
+        auto loaded = future.get();
+        weights.insert(weights.end(), loaded.begin(), loaded.end());
     }
 
     return weights;
 }
 
+size_t pack_tensors(const std::filesystem::path& dir) {
+    std::vector<std::string> names;
+    std::vector<SourceStamp> source_stamps;
+    std::vector<torch::Tensor> tensors;
+    for (const auto& path : tensor_files(dir)) {
+        // Stamp the file before reading it, so that a concurrent change makes the packed file
+        // out of date rather than silently stale.
+        source_stamps.push_back(source_stamp(path));
+        std::vector<torch::Tensor> loaded;
+        torch::load(loaded, path.string());
+        if (loaded.size() != 1) {
+            throw std::runtime_error("Expected a single tensor in " + path.string());
+        }
+        names.push_back(path.filename().string());
+        tensors.push_back(loaded.front().to(torch::kCPU).contiguous());
+    }
+
+    std::string header(kPackedMagic, sizeof(kPackedMagic));
+    auto append = [&header](const auto& value) {
+        header.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    append(kPackedVersion);
+    append(static_cast<uint32_t>(tensors.size()));
+
+    // Offsets depend on the header size, so lay the header out with placeholder offsets
+    // first and patch them once the header size is known.
+    std::vector<size_t> offset_positions;
+    for (size_t i = 0; i < tensors.size(); ++i) {
+        append(static_cast<uint32_t>(names[i].size()));
+        header += names[i];
+        append(static_cast<int32_t>(tensors[i].scalar_type()));
+        append(static_cast<uint32_t>(tensors[i].dim()));
+        for (auto size : tensors[i].sizes()) {
+            append(static_cast<int64_t>(size));
+        }
+        offset_positions.push_back(header.size());
+        append(uint64_t(0));
+        append(static_cast<uint64_t>(tensors[i].nbytes()));
+        append(source_stamps[i].first);
+        append(source_stamps[i].second);
+    }
+
+    uint64_t offset = header.size();
+    std::vector<uint64_t> offsets;
+    for (size_t i = 0; i < tensors.size(); ++i) {
+        offset = pad_to(offset, kPackedAlignment);
+        offsets.push_back(offset);
+        std::memcpy(&header[offset_positions[i]], &offset, sizeof(offset));
+        offset += tensors[i].nbytes();
+    }
+
+    // Write to a temporary file and rename it into place, so that an interrupted pack never
+    // leaves a partial file to be loaded.
+    const auto packed_path = dir / kPackedTensorsFilename;
+    std::ostringstream temp_name;
+    temp_name << kPackedTensorsFilename << ".tmp"
+              << std::chrono::steady_clock::now().time_since_epoch().count();
+    const auto temp_path = dir / temp_name.str();
+    {
+        std::ofstream fout(temp_path, std::ios::binary);
+        fout.write(header.data(), header.size());
+        uint64_t written = header.size();
+        const char padding[kPackedAlignment] = {};
+        for (size_t i = 0; i < tensors.size(); ++i) {
+            fout.write(padding, offsets[i] - written);
+            fout.write(static_cast<const char*>(tensors[i].data_ptr()), tensors[i].nbytes());
+            written = offsets[i] + tensors[i].nbytes();
+        }
+        if (!fout.flush()) {
+            fout.close();
+            std::filesystem::remove(temp_path);
+            throw std::runtime_error("Failed to write " + packed_path.string());
+        }
+    }
+    std::filesystem::rename(temp_path, packed_path);
+
+    return tensors.size();
+}
+
 torch::Tensor quantile(const torch::Tensor t, const torch::Tensor q) {
     assert(q.dtype() == torch::kF32);
 
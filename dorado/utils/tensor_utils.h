@@ -12,9 +12,22 @@ namespace dorado::utils {
 // Serialise Torch tensor to disk.
 void serialise_tensor(torch::Tensor t, const std::string& path);
 // Load serialised tensor from disk.
+// If `dir` contains a packed tensor file (see `pack_tensors`) which is up to date with the
+// .tensor files, the tensors are memory-mapped from it instead of being deserialised one file
+// at a time.
 std::vector<torch::Tensor> load_tensors(const std::filesystem::path& dir,
                                         const std::vector<std::string>& tensors);
 
+// Name of the packed tensor file within a model directory.
+constexpr char kPackedTensorsFilename[] = "weights.packed";
+
+// Packs every serialised .tensor file in `dir` into a single file, `dir/kPackedTensorsFilename`,
+// consisting of one header followed by the raw tensor data at 64-byte aligned offsets.  The
+// header records the size and modification time of each .tensor file, and the file is replaced
+// atomically.
+// Returns the number of tensors packed.
+size_t pack_tensors(const std::filesystem::path& dir);
+
 // Computes the q-th quantiles of each row of the input tensor `t`
 // using a partial sort as opposed a full sort per torch::quantiles
 // Only `interpolation='lower'` is currently implemented.
@@ -0,0 +1,117 @@
+#include "utils/adapter_index.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define CUT_TAG "[AdapterIndex]"
+
+using dorado::utils::AdapterIndex;
+
+namespace {
+
+// Reference infix search, aligning the adapter to every substring of [begin, end) with a full
+// dynamic programming matrix.  Picks the lowest edit distance, then the earliest end, then the
+// longest alignment, as edlib does.
+std::optional<AdapterIndex::Match> best_match_reference(const std::string& adapter,
+                                                        const std::string& seq,
+                                                        uint64_t begin,
+                                                        uint64_t end,
+                                                        int max_edist) {
+    std::optional<AdapterIndex::Match> best;
+    for (uint64_t match_end = begin; match_end < end; ++match_end) {
+        for (uint64_t match_start = begin; match_start <= match_end + 1; ++match_start) {
+            const std::string text = seq.substr(match_start, match_end + 1 - match_start);
+            std::vector<std::vector<int>> dists(adapter.size() + 1,
+                                                std::vector<int>(text.size() + 1));
+            for (size_t i = 0; i <= adapter.size(); ++i) {
+                for (size_t j = 0; j <= text.size(); ++j) {
+                    if (i == 0 || j == 0) {
+                        dists[i][j] = int(i + j);
+                    } else {
+                        const int mismatch = adapter[i - 1] != text[j - 1];
+                        dists[i][j] = std::min({dists[i - 1][j - 1] + mismatch,
+                                                dists[i - 1][j] + 1, dists[i][j - 1] + 1});
+                    }
+                }
+            }
+            const int edist = dists[adapter.size()][text.size()];
+            if (edist <= max_edist && (!best || edist < best->edist)) {
+                best = AdapterIndex::Match{{match_start, match_end + 1}, edist};
+            }
+        }
+    }
+    return best;
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG ": best matches agree with a full alignment", CUT_TAG) {
+    std::mt19937 gen(42);
+    const std::string bases = "ACGT";
+    for (int trial = 0; trial < 100; ++trial) {
+        std::string adapter(3 + gen() % 8, 'A');
+        for (auto& base : adapter) {
+            base = bases[gen() % 4];
+        }
+        std::string seq(gen() % 40, 'A');
+        for (auto& base : seq) {
+            base = bases[gen() % 4];
+        }
+        // Plant a copy of the adapter with one substitution in half of the sequences.
+        if (seq.size() > adapter.size() && trial % 2 == 0) {
+            auto copy = adapter;
+            copy[gen() % copy.size()] = bases[gen() % 4];
+            seq.replace(gen() % (seq.size() - adapter.size() + 1), copy.size(), copy);
+        }
+
+        const int max_edist = 3;
+        const AdapterIndex index(adapter, seq, max_edist);
+        for (int query = 0; query < 5; ++query) {
+            const uint64_t begin = gen() % (seq.size() + 1);
+            const uint64_t end = begin + gen() % (seq.size() - begin + 1);
+            const int edist = gen() % (max_edist + 1);
+            CAPTURE(adapter, seq, begin, end, edist);
+
+            const auto expected = best_match_reference(adapter, seq, begin, end, edist);
+            const auto match = index.best_match({begin, end}, edist);
+            REQUIRE(match.has_value() == expected.has_value());
+            if (match) {
+                CHECK(match->range == expected->range);
+                CHECK(match->edist == expected->edist);
+            }
+        }
+    }
+}
+
+TEST_CASE(CUT_TAG ": finds every occurrence", CUT_TAG) {
+    const std::string adapter = "TACTTCGTTCAGTTACGTATTGCT";
+    const std::string spacer(50, 'G');
+    // An exact copy, a copy with a substitution and a deletion, and an exact copy at the end.
+    auto damaged = adapter;
+    damaged[5] = 'A';
+    damaged.erase(15, 1);
+    const std::string seq = spacer + adapter + spacer + damaged + spacer + adapter;
+
+    const AdapterIndex index(adapter, seq, 8);
+    const auto strict = index.matches({0, seq.size()}, 1);
+    REQUIRE(strict.size() == 2);
+    CHECK(strict[0].range == AdapterIndex::PosRange{50, 74});
+    CHECK(strict[0].edist == 0);
+    CHECK(strict[1].range == AdapterIndex::PosRange{seq.size() - 24, seq.size()});
+
+    const auto relaxed = index.matches({0, seq.size()}, 4);
+    REQUIRE(relaxed.size() == 3);
+    CHECK(relaxed[1].range == AdapterIndex::PosRange{124, 147});
+    CHECK(relaxed[1].edist == 2);
+
+    // Matches must lie within the searched range, so clipped copies are no longer exact.
+    CHECK(index.matches({51, seq.size() - 1}, 0).empty());
+    CHECK(index.matches({51, seq.size() - 1}, 1).size() == 2);
+    CHECK_THROWS_AS(index.matches({0, seq.size()}, 9), std::runtime_error);
+}
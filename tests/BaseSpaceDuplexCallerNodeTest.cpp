@@ -0,0 +1,77 @@
+#include "read_pipeline/BaseSpaceDuplexCallerNode.h"
+
+#include "MessageSinkUtils.h"
+#include "utils/sequence_utils.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <random>
+
+#define TEST_GROUP "[read_pipeline][BaseSpaceDuplexCallerNode]"
+
+namespace {
+
+std::shared_ptr<dorado::Read> make_read(const std::string& read_id, const std::string& seq) {
+    auto read = std::make_shared<dorado::Read>();
+    read->read_id = read_id;
+    read->seq = seq;
+    read->qstring = std::string(seq.size(), '5');
+    return read;
+}
+
+std::string random_sequence(std::mt19937& gen, size_t length) {
+    std::uniform_int_distribution<int> base_dist(0, 3);
+    std::string seq(length, 'A');
+    std::generate(seq.begin(), seq.end(), [&] { return "ACGT"[base_dist(gen)]; });
+    return seq;
+}
+
+}  // namespace
+
+TEST_CASE("Streamed reads are paired in any order", TEST_GROUP) {
+    std::mt19937 gen(42);
+    std::map<std::string, std::string> seqs;
+    for (const auto& template_id : {"t1", "t2", "t3"}) {
+        seqs[template_id] = random_sequence(gen, 400);
+    }
+
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, 100, messages);
+    pipeline_desc.add_node<dorado::BaseSpaceDuplexCallerNode>(
+            {sink}, std::map<std::string, std::string>{{"t1", "c1"}, {"t2", "c2"}, {"t3", "c3"}},
+            2);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc));
+
+    auto complement = [&](const std::string& template_id) {
+        return dorado::utils::reverse_complement(seqs.at(template_id));
+    };
+    // The complement of the first pair arrives before its template, and the complement of the
+    // last pair never arrives.
+    pipeline->push_message(make_read("c1", complement("t1")));
+    pipeline->push_message(make_read("t2", seqs.at("t2")));
+    pipeline->push_message(make_read("t1", seqs.at("t1")));
+    pipeline->push_message(make_read("unpaired", seqs.at("t1")));
+    pipeline->push_message(make_read("c2", complement("t2")));
+    pipeline->push_message(make_read("t3", seqs.at("t3")));
+    // Repeated records of a read which has already been paired are ignored.
+    pipeline->push_message(make_read("t1", seqs.at("t1")));
+    pipeline->push_message(make_read("c1", complement("t1")));
+    pipeline.reset();
+
+    auto reads = ConvertMessages<std::shared_ptr<dorado::Read>>(messages);
+    std::sort(reads.begin(), reads.end(),
+              [](const auto& a, const auto& b) { return a->read_id < b->read_id; });
+    REQUIRE(reads.size() == 2);
+    CHECK(reads[0]->read_id == "t1;c1");
+    CHECK(reads[1]->read_id == "t2;c2");
+    for (const auto& read : reads) {
+        CHECK(read->is_duplex);
+        // Both strands match, so the consensus follows the template.
+        const auto& template_seq = seqs.at(read->read_id.substr(0, 2));
+        CHECK(!read->seq.empty());
+        CHECK(template_seq.compare(0, read->seq.size(), read->seq) == 0);
+        CHECK(read->qstring == std::string(read->seq.size(), '5'));
+    }
+}
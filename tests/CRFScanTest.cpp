@@ -0,0 +1,74 @@
+#include "decode/crf_scan.h"
+
+#include <catch2/catch.hpp>
+#include <torch/torch.h>
+
+#define CUT_TAG "[CRFScan]"
+
+namespace {
+
+// Reference implementation of the forward/backward scan using torch ops.
+torch::Tensor torch_scan(const torch::Tensor& Ms,
+                         const float fixed_stay_score,
+                         const torch::Tensor& idx,
+                         const torch::Tensor& v0) {
+    const int T = Ms.size(0);
+    const int N = Ms.size(1);
+    const int C = Ms.size(2);
+
+    torch::Tensor alpha = Ms.new_full({T + 1, N, C}, -1E38);
+    alpha[0] = v0;
+
+    for (int t = 0; t < T; t++) {
+        auto scored_steps = torch::add(alpha.index({t, torch::indexing::Slice(), idx}), Ms[t]);
+        auto scored_stay = torch::add(alpha.index({t, torch::indexing::Slice()}), fixed_stay_score)
+                                   .unsqueeze(-1);
+        auto scored_transitions = torch::cat({scored_stay, scored_steps}, -1);
+
+        alpha[t + 1] = torch::logsumexp(scored_transitions, -1);
+    }
+
+    return alpha;
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG ": matches torch forward/backward scan", CUT_TAG) {
+    torch::manual_seed(42);
+
+    const int T = 50;
+    const int N = 3;
+    const int num_states = 64;
+    const float stay = 2.0f;
+
+    const auto scores = torch::randn({T, N, num_states * 4}) * 2.0f;
+
+    const auto idx = torch::arange(num_states)
+                             .repeat_interleave(4)
+                             .reshape({4, -1})
+                             .t()
+                             .contiguous();
+    const auto fwd = torch_scan(scores.reshape({T, N, -1, 4}), stay, idx,
+                                scores.new_full({N, num_states}, 0.0f));
+
+    auto idx_T = idx.flatten().argsort().reshape(idx.sizes());
+    const auto Ms_T = scores.index({torch::indexing::Slice(), torch::indexing::Slice(), idx_T});
+    idx_T = torch::bitwise_right_shift(idx_T, 2);
+    const auto bwd = torch_scan(Ms_T.flip(0), stay, idx_T.to(torch::kInt64),
+                                scores.new_full({N, num_states}, 0.0f))
+                             .flip(0);
+    const auto posts = torch::softmax(fwd + bwd, -1);
+
+    dorado::CRFScan scan(num_states);
+    for (int n = 0; n < N; ++n) {
+        const auto chunk_scores = scores.select(1, n);
+        scan.run(chunk_scores.data_ptr<float>(), T, chunk_scores.stride(0), stay);
+
+        const auto scan_bwd = torch::from_blob(const_cast<float*>(scan.back_guides()),
+                                               {T + 1, num_states});
+        const auto scan_posts =
+                torch::from_blob(const_cast<float*>(scan.posts()), {T + 1, num_states});
+        CHECK(torch::allclose(scan_bwd, bwd.select(1, n), 1e-5, 1e-4));
+        CHECK(torch::allclose(scan_posts, posts.select(1, n), 1e-4, 1e-5));
+    }
+}
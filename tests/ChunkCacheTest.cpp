@@ -0,0 +1,142 @@
+#include "read_pipeline/ReadPipeline.h"
+#include "utils/chunk_cache.h"
+
+#include <catch2/catch.hpp>
+#include <torch/torch.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#define CUT_TAG "[ChunkCache]"
+
+namespace {
+
+// Writes a model directory holding a single weights file.
+std::filesystem::path make_model(const std::filesystem::path& model_path,
+                                 const std::string& weights) {
+    std::filesystem::create_directories(model_path);
+    std::ofstream(model_path / "conv1.weight.tensor", std::ios::binary) << weights;
+    return model_path;
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG ": store and load round trip", CUT_TAG) {
+    torch::manual_seed(42);
+
+    const auto dir = std::filesystem::temp_directory_path() / "dorado_chunk_cache_test";
+    std::filesystem::remove_all(dir);
+    const auto model_a = make_model(dir / "models" / "model_a", "weights");
+
+    const dorado::utils::ChunkCache cache(dir / "cache", "cuda:0", "beam_search", model_a);
+    const auto signal = torch::randn({1, 4000}, torch::kFloat16);
+    const auto key = cache.key(signal);
+
+    dorado::Chunk stored(nullptr, 0, 0, 4000);
+    stored.seq = "ACGTTGCA";
+    stored.moves = {1, 0, 1, 1, 0, 1, 1, 1, 0, 1, 1};
+    stored.base_error_probs = {0.1f, 0.2f, 0.01f, 0.5f, 0.3f, 0.02f, 0.04f, 0.001f};
+    stored.q_shift = -0.5f;
+    stored.q_scale = 1.1f;
+
+    dorado::Chunk loaded(nullptr, 0, 0, 4000);
+    CHECK_FALSE(cache.load(key, loaded));
+
+    cache.store(key, stored);
+    REQUIRE(cache.load(key, loaded));
+    CHECK(loaded.seq == stored.seq);
+    CHECK(loaded.qstring.empty());
+    CHECK(loaded.moves == stored.moves);
+    CHECK(loaded.base_error_probs == stored.base_error_probs);
+    CHECK(loaded.q_shift == stored.q_shift);
+    CHECK(loaded.q_scale == stored.q_scale);
+
+    // A different decoder doesn't see entries written with other settings.
+    const dorado::utils::ChunkCache viterbi_cache(dir / "cache", "cuda:0", "viterbi", model_a);
+    CHECK_FALSE(viterbi_cache.load(viterbi_cache.key(signal), loaded));
+
+    // Nor does another type of device, whose chunks may carry a qstring instead.
+    const dorado::utils::ChunkCache cpu_cache(dir / "cache", "cpu", "beam_search", model_a);
+    CHECK_FALSE(cpu_cache.load(cpu_cache.key(signal), loaded));
+
+    // Any device of the same type shares the entries.
+    const dorado::utils::ChunkCache other_gpu_cache(dir / "cache", "cuda:all", "beam_search",
+                                                    model_a);
+    CHECK(other_gpu_cache.load(other_gpu_cache.key(signal), loaded));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE(CUT_TAG ": keys depend on the model and signal", CUT_TAG) {
+    torch::manual_seed(42);
+
+    const auto dir = std::filesystem::temp_directory_path() / "dorado_chunk_cache_key_test";
+    std::filesystem::remove_all(dir);
+    const auto model_a = make_model(dir / "models" / "model_a", "weights");
+    const auto model_b = make_model(dir / "models" / "model_b", "weights");
+
+    const dorado::utils::ChunkCache cache(dir / "cache", "cuda:0", "beam_search", model_a);
+    const dorado::utils::ChunkCache cache_b(dir / "cache", "cuda:0", "beam_search", model_b);
+    const auto signal = torch::randn({1, 4000}, torch::kFloat16);
+
+    const auto key = cache.key(signal);
+    CHECK(key == cache.key(signal.clone()));
+    CHECK(key != cache_b.key(signal));
+
+    auto changed = signal.clone();
+    changed[0][1234] += 1.0f;
+    CHECK(key != cache.key(changed));
+    // The same bytes with a different shape are a different chunk.
+    CHECK(key != cache.key(signal.view({2, 2000})));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE(CUT_TAG ": changed model weights miss the cache", CUT_TAG) {
+    torch::manual_seed(42);
+
+    const auto dir = std::filesystem::temp_directory_path() / "dorado_chunk_cache_model_test";
+    std::filesystem::remove_all(dir);
+    const auto model = make_model(dir / "model", "weights");
+    const auto signal = torch::randn({1, 4000}, torch::kFloat16);
+
+    dorado::Chunk stored(nullptr, 0, 0, 4000);
+    stored.seq = "ACGT";
+    stored.moves = {1, 1, 0, 1, 1};
+    stored.base_error_probs = {0.1f, 0.2f, 0.01f, 0.5f};
+    {
+        const dorado::utils::ChunkCache cache(dir / "cache", "cpu", "beam_search", model);
+        cache.store(cache.key(signal), stored);
+    }
+
+    dorado::Chunk loaded(nullptr, 0, 0, 4000);
+    SECTION("Unchanged weights hit") {
+        const dorado::utils::ChunkCache cache(dir / "cache", "cpu", "beam_search", model);
+        CHECK(cache.load(cache.key(signal), loaded));
+    }
+
+    SECTION("Resized weights miss") {
+        make_model(model, "retrained weights");
+        const dorado::utils::ChunkCache cache(dir / "cache", "cpu", "beam_search", model);
+        CHECK_FALSE(cache.load(cache.key(signal), loaded));
+    }
+
+    SECTION("Rewritten weights of the same size miss") {
+        const auto weights = model / "conv1.weight.tensor";
+        const auto write_time = std::filesystem::last_write_time(weights);
+        make_model(model, "WEIGHTS");
+        std::filesystem::last_write_time(weights, write_time + std::chrono::seconds(1));
+        const dorado::utils::ChunkCache cache(dir / "cache", "cpu", "beam_search", model);
+        CHECK_FALSE(cache.load(cache.key(signal), loaded));
+    }
+
+    SECTION("Added weights miss") {
+        std::ofstream(model / "weights.packed", std::ios::binary) << "packed";
+        const dorado::utils::ChunkCache cache(dir / "cache", "cpu", "beam_search", model);
+        CHECK_FALSE(cache.load(cache.key(signal), loaded));
+    }
+
+    std::filesystem::remove_all(dir);
+}
@@ -49,3 +49,17 @@ TEST_CASE("CliUtils: Extract tokens from dorado cmdline", TEST_GROUP) {
         CHECK(tokens[i] == expected_tokens[i]);
     }
 }
+
+TEST_CASE("CliUtils: Check CPU decode thread option", TEST_GROUP) {
+    SECTION("defaults to 0") {
+        auto parser = parse_internal_options({});
+        CHECK(parser.get<int>("--cpu-decode-threads") == 0);
+    }
+    SECTION("accepts a thread count") {
+        auto parser = parse_internal_options({"--cpu-decode-threads", "4"});
+        CHECK(parser.get<int>("--cpu-decode-threads") == 4);
+    }
+    SECTION("rejects negative counts") {
+        CHECK_THROWS(parse_internal_options({"--cpu-decode-threads", "-2"}));
+    }
+}
@@ -21,7 +21,7 @@ std::filesystem::path DataPath(std::string_view filename) {
     return std::filesystem::path(get_split_data_dir()) / filename;
 }
 
-std::shared_ptr<dorado::Read> make_read() {
+std::shared_ptr<dorado::Read> make_read(torch::Dtype signal_type = torch::kFloat16) {
     std::shared_ptr<dorado::Read> read = std::make_shared<dorado::Read>();
     read->range = 0;
     read->sample_rate = 4000;
@@ -45,7 +45,7 @@ std::shared_ptr<dorado::Read> make_read() {
     read->qstring = ReadFileIntoString(DataPath("qstring"));
     read->moves = ReadFileIntoVector(DataPath("moves"));
     torch::load(read->raw_data, DataPath("raw.tensor").string());
-    read->raw_data = read->raw_data.to(torch::kFloat16);
+    read->raw_data = read->raw_data.to(signal_type);
     read->read_tag = 42;
 
     return read;
@@ -97,6 +97,21 @@ TEST_CASE("4 subread splitting test", TEST_GROUP) {
                         [](const auto &r) { return r->read_tag == 42; }));
 }
 
+TEST_CASE("4 subread splitting test on float32 signal", TEST_GROUP) {
+    // The open pore scan reads float32 signal as it is, rather than rounding it to float16.
+    const auto read = make_read(torch::kFloat32);
+
+    dorado::DuplexSplitSettings splitter_settings;
+    dorado::DuplexSplitNode splitter_node(splitter_settings, 1);
+
+    const auto split_res = splitter_node.split(read);
+    std::vector<int> split_sizes;
+    for (auto &r : split_res) {
+        split_sizes.push_back(r->seq.size());
+    }
+    REQUIRE(split_sizes == std::vector<int>{6858, 7854, 5184, 5168});
+}
+
 TEST_CASE("4 subread split tagging", TEST_GROUP) {
     const auto read = make_read();
 
@@ -0,0 +1,89 @@
+#include "utils/motif_scanner.h"
+
+#include <catch2/catch.hpp>
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define CUT_TAG "[MotifScanner]"
+
+using dorado::utils::MotifScanner;
+
+namespace {
+
+// The bases matched by each motif code used in these tests.
+bool code_matches(char code, char base) {
+    static const std::map<char, std::string> kCodeBases{
+            {'A', "A"},  {'C', "C"},   {'G', "G"},   {'T', "T"},
+            {'R', "AG"}, {'H', "ACT"}, {'D', "AGT"}, {'N', "ACGT"}};
+    return kCodeBases.at(code).find(base) != std::string::npos;
+}
+
+// Reference implementation, checking every base at every position.
+std::vector<uint32_t> find_hits(const std::string& seq, const std::string& motif, size_t offset) {
+    std::vector<uint32_t> hits;
+    for (size_t pos = 0; !motif.empty() && pos + motif.size() <= seq.size(); ++pos) {
+        bool match = true;
+        for (size_t i = 0; i < motif.size() && match; ++i) {
+            match = code_matches(motif[i], seq[pos + i]);
+        }
+        if (match) {
+            hits.push_back(uint32_t(pos + offset));
+        }
+    }
+    return hits;
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG ": finds every motif in one pass", CUT_TAG) {
+    const std::vector<std::string> motifs{"CG", "A", "GATC", "", "GGXCT", "CG"};
+    const std::vector<size_t> offsets{0, 0, 1, 0, 2, 1};
+
+    SECTION("Invalid motifs are rejected") {
+        CHECK_THROWS_AS(MotifScanner(motifs, offsets), std::runtime_error);
+    }
+
+    const std::vector<std::string> valid_motifs{"CG", "A", "GATC", "", "GGACT", "CG"};
+    const MotifScanner scanner(valid_motifs, offsets);
+    REQUIRE(scanner.num_motifs() == valid_motifs.size());
+
+    // Hits at both ends, overlapping hits, and non-ACGT bases breaking up motifs.
+    const std::string seq = "CGATCGGACTAAGATCNGATGGACTCGCGCG";
+    const auto hits = scanner.scan(seq);
+    REQUIRE(hits.size() == valid_motifs.size());
+    for (size_t i = 0; i < valid_motifs.size(); ++i) {
+        CAPTURE(valid_motifs[i]);
+        CHECK(hits[i] == find_hits(seq, valid_motifs[i], offsets[i]));
+    }
+    CHECK(hits[0] == std::vector<uint32_t>{0, 4, 25, 27, 29});
+    CHECK(hits[3].empty());
+}
+
+TEST_CASE(CUT_TAG ": motifs must fit in the scanner", CUT_TAG) {
+    CHECK_THROWS_AS(MotifScanner({std::string(40, 'A'), std::string(25, 'C')}, {0, 0}),
+                    std::runtime_error);
+    CHECK_NOTHROW(MotifScanner({std::string(40, 'A'), std::string(24, 'C')}, {0, 0}));
+    CHECK_THROWS_AS(MotifScanner({"CG"}, {2}), std::runtime_error);
+    CHECK_THROWS_AS(MotifScanner({"CG"}, {}), std::runtime_error);
+}
+
+TEST_CASE(CUT_TAG ": matches IUPAC codes", CUT_TAG) {
+    const std::vector<std::string> motifs{"DRACH", "GATC", "CNG"};
+    const std::vector<size_t> offsets{2, 1, 0};
+    const MotifScanner scanner(motifs, offsets);
+
+    // DRACH matches GGACT, AAACA and TGACC, but not CGACT (C is not D) or GGACG (G is not H).
+    const std::string seq = "GGACTCAGAAACATGACCGATCCGACTGGGACGNCCAG";
+    const auto hits = scanner.scan(seq);
+    REQUIRE(hits.size() == motifs.size());
+    for (size_t i = 0; i < motifs.size(); ++i) {
+        CAPTURE(motifs[i]);
+        CHECK(hits[i] == find_hits(seq, motifs[i], offsets[i]));
+    }
+    CHECK(hits[0] == std::vector<uint32_t>{2, 10, 15});
+    // N matches any base, but a non-ACGT base in the sequence matches nothing.
+    CHECK(hits[2] == std::vector<uint32_t>{5, 16, 21, 25, 35});
+}
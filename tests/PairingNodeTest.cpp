@@ -87,3 +87,31 @@ TEST_CASE("Split read pairing", TEST_GROUP) {
             });
     CHECK(num_pairs == 2);
 }
+
+TEST_CASE("Pore limit applies across the whole node", TEST_GROUP) {
+    // In channel order only the 10 most recent pores are kept, wherever they are stored, so
+    // reads from the oldest pores are sent on as soon as newer pores arrive.
+    const int kNumPores = 20;
+    const int kMaxPores = 10;
+
+    dorado::PipelineDescriptor pipeline_desc;
+    std::vector<dorado::Message> messages;
+    auto sink = pipeline_desc.add_node<MessageSinkToVector>({}, kNumPores, messages);
+    auto pairing_node = pipeline_desc.add_node<dorado::PairingNode>(
+            {sink}, dorado::ReadOrder::BY_CHANNEL, 1, kNumPores);
+    auto pipeline = dorado::Pipeline::create(std::move(pipeline_desc));
+
+    for (int channel = 0; channel < kNumPores; ++channel) {
+        auto read = make_read(0, 1000);
+        read->attributes.channel_number = channel;
+        pipeline->push_message(std::move(read));
+    }
+    // Keep the reads of the live pores, so only evicted reads reach the sink.
+    pipeline->terminate(dorado::FlushOptions{true});
+
+    REQUIRE(messages.size() == kNumPores - kMaxPores);
+    for (int i = 0; i < kNumPores - kMaxPores; ++i) {
+        const auto& read = std::get<std::shared_ptr<dorado::Read>>(messages[i]);
+        CHECK(read->attributes.channel_number == i);
+    }
+}
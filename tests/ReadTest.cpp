@@ -128,28 +128,22 @@ void require_sam_tag_B_int_matches(const uint8_t* aux, const std::vector<int64_t
 TEST_CASE(TEST_GROUP ": Methylation tag generation", TEST_GROUP) {
     std::string modbase_alphabet = "AXCYGT";
     std::string modbase_long_names = "6mA 5mC";
+    // Only some positions have probabilities, every other base is unmodified.
+    std::vector<uint32_t> modbase_positions = {0, 1, 6, 7, 11, 12};
     std::vector<uint8_t> modbase_probs = {
-            235, 20,  0,   0,   0,   0,    // A 6ma (weak call)
-            0,   0,   255, 0,   0,   0,    // C
-            255, 0,   0,   0,   0,   0,    // A
-            0,   0,   0,   0,   255, 0,    // G
-            0,   0,   0,   0,   0,   255,  // T
-            0,   0,   0,   0,   255, 0,    // G
-            1,   254, 0,   0,   0,   0,    // A 6ma
-            0,   0,   3,   252, 0,   0,    // C 5ma
-            0,   0,   0,   0,   0,   255,  // T
-            255, 0,   0,   0,   0,   0,    // A
-            255, 0,   0,   0,   0,   0,    // A
-            255, 0,   0,   0,   0,   0,    // A
-            0,   0,   3,   252, 0,   0,    // C 6ma
-            0,   0,   0,   0,   0,   255,  // T
-            0,   0,   255, 0,   0,   0,    // C
+            235, 20,  0,   0,   0, 0,  // A 6ma (weak call)
+            0,   0,   255, 0,   0, 0,  // C
+            1,   254, 0,   0,   0, 0,  // A 6ma
+            0,   0,   3,   252, 0, 0,  // C 5ma
+            255, 0,   0,   0,   0, 0,  // A
+            0,   0,   3,   252, 0, 0,  // C 6ma
     };
 
     dorado::Read read;
     read.read_id = "read";
     read.seq = "ACAGTGACTAAACTC";
     read.qstring = "***************";
+    read.base_mod_positions = modbase_positions;
     read.base_mod_probs = modbase_probs;
     read.is_duplex = false;
 
@@ -204,6 +198,7 @@ TEST_CASE(TEST_GROUP ": Methylation tag generation", TEST_GROUP) {
     }
 
     SECTION("Test generation using AC context for A methylation") {
+        // The positions include every A in an AC context.
         std::string context = "XC:_:_:_";
         const char* expected_methylation_tag_with_context = "A+a?,0,1,2;C+m.,1,0;";
         std::vector<int64_t> expected_methylation_tag_with_context_prob{20, 254, 0, 252, 252};
@@ -220,6 +215,22 @@ TEST_CASE(TEST_GROUP ": Methylation tag generation", TEST_GROUP) {
                                       expected_methylation_tag_with_context_prob);
     }
 
+    SECTION("Positions without probabilities are unmodified") {
+        read.base_mod_info =
+                std::make_shared<dorado::BaseModInfo>(modbase_alphabet, modbase_long_names, "");
+
+        // A threshold of 0 includes every base, with those missing a row having probability 0.
+        const char* expected_methylation_tag_0_score = "A+a.,0,0,0,0,0,0;C+m.,0,0,0,0;";
+        std::vector<int64_t> expected_methylation_tag_0_score_prob{20, 0, 254, 0,   0,
+                                                                   0,  0, 252, 252, 0};
+        auto lines = read.extract_sam_lines(false, 0);
+        REQUIRE(!lines.empty());
+        bam1_t* aln = lines[0].get();
+        CHECK_THAT(bam_aux2Z(bam_aux_get(aln, "MM")), Equals(expected_methylation_tag_0_score));
+        require_sam_tag_B_int_matches(bam_aux_get(aln, "ML"),
+                                      expected_methylation_tag_0_score_prob);
+    }
+
     SECTION("Test handling of incorrect base names") {
         std::string modbase_long_names_unknown = "12mA 5mq";
 
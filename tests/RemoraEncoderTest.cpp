@@ -2,9 +2,20 @@
 #include "utils/sequence_utils.h"
 
 #include <catch2/catch.hpp>
+#include <torch/torch.h>
 
 #define TEST_GROUP "[remora_encoder]"
 
+namespace {
+
+std::vector<int8_t> to_vector(const torch::Tensor& data) {
+    REQUIRE(data.is_contiguous());
+    const auto* ptr = data.data_ptr<int8_t>();
+    return {ptr, ptr + data.numel()};
+}
+
+}  // namespace
+
 TEST_CASE("Encode sequence for modified basecalling", TEST_GROUP) {
     const size_t BLOCK_STRIDE = 2;
     const size_t KMER_LEN = 3;
@@ -42,7 +53,7 @@ TEST_CASE("Encode sequence for modified basecalling", TEST_GROUP) {
         1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, // ATT
     };    
     // clang-format on    
-    CHECK(expected_slice0 == slice0.data);
+    CHECK(expected_slice0 == to_vector(slice0.data));
 
     auto slice1 = encoder.get_context(4);  // The C in the TCA 3mer.
     CHECK(slice1.first_sample == 10);
@@ -66,7 +77,7 @@ TEST_CASE("Encode sequence for modified basecalling", TEST_GROUP) {
         0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0, // CAG
     };
     // clang-format on
-    CHECK(expected_slice1 == slice1.data);
+    CHECK(expected_slice1 == to_vector(slice1.data));
 
     auto slice2 = encoder.get_context(9);  // The C in the ACN 3mer.
     CHECK(slice2.first_sample == 31);
@@ -90,5 +101,23 @@ TEST_CASE("Encode sequence for modified basecalling", TEST_GROUP) {
         1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, // ACN
     };
     // clang-format on    
-    CHECK(expected_slice2 == slice2.data);
+    CHECK(expected_slice2 == to_vector(slice2.data));
+
+    // A window spanning several contexts holds the same rows as each of them.
+    const auto window_rows = slice2.encoding_row + 12 - slice0.encoding_row;
+    const auto window = encoder.encode_rows(slice0.encoding_row, window_rows);
+    CHECK(slice0.data.sizes() == torch::IntArrayRef{12, 12});
+    CHECK(window.sizes() == torch::IntArrayRef{int64_t(window_rows), 12});
+    for (const auto& slice : {slice0, slice1, slice2}) {
+        CHECK(to_vector(slice.data) ==
+              to_vector(window.narrow(0, slice.encoding_row - slice0.encoding_row, 12)));
+    }
+    // The encoding has 40 rows for the signal, 6 before it and 8 after it.
+    CHECK(encoder.encode_rows(0, 54).size(0) == 54);
+    CHECK_THROWS_AS(encoder.encode_rows(0, 55), std::out_of_range);
+
+    const auto bounds1 = encoder.get_context_bounds(4);
+    CHECK_FALSE(bounds1.data.defined());
+    CHECK(bounds1.encoding_row == slice1.encoding_row);
+    CHECK(bounds1.first_sample == slice1.first_sample);
 }
@@ -0,0 +1,93 @@
+#include "nn/RemoraModel.h"
+
+#include <catch2/catch.hpp>
+#include <torch/torch.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#define CUT_TAG "[RemoraModel]"
+
+namespace {
+
+constexpr int kSize = 16;
+constexpr int kKmerLen = 9;
+constexpr int kNumOut = 3;
+constexpr int kContextSamples = 100;
+
+// Name, weight shape and stride of each layer of a conv_only model, in forward order.
+const std::vector<std::tuple<std::string, std::vector<int64_t>, int>> kConvLayers{
+        {"sig_conv1", {4, 1, 11}, 1},
+        {"sig_conv2", {16, 4, 11}, 1},
+        {"sig_conv3", {kSize, 16, 9}, 3},
+        {"seq_conv1", {16, kKmerLen * 4, 11}, 1},
+        {"seq_conv2", {32, 16, 11}, 1},
+        {"seq_conv3", {kSize, 32, 9}, 3},
+        {"merge_conv1", {kSize, kSize * 2, 5}, 1},
+        {"merge_conv2", {kSize, kSize, 5}, 1},
+        {"merge_conv3", {kSize, kSize, 3}, 2},
+        {"merge_conv4", {kSize, kSize, 3}, 2},
+};
+
+void save_tensor(const std::filesystem::path& path, const torch::Tensor& tensor) {
+    torch::save(std::vector<torch::Tensor>{tensor}, path.string());
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG ": CPU conv model matches reference", CUT_TAG) {
+    torch::manual_seed(42);
+    torch::InferenceMode guard;
+
+    const auto dir = std::filesystem::temp_directory_path() / "dorado_remora_model_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "config.toml") << "[general]\nmodel = \"conv_only\"\n\n"
+                                       << "[model_params]\nsize = " << kSize
+                                       << "\nkmer_len = " << kKmerLen << "\nnum_out = " << kNumOut
+                                       << "\n";
+
+    std::vector<std::pair<torch::Tensor, torch::Tensor>> conv_weights;
+    for (const auto& [name, shape, stride] : kConvLayers) {
+        conv_weights.emplace_back(torch::randn(shape) * 0.3f, torch::randn({shape[0]}) * 0.3f);
+        save_tensor(dir / (name + ".weight.tensor"), conv_weights.back().first);
+        save_tensor(dir / (name + ".bias.tensor"), conv_weights.back().second);
+    }
+    const auto fc_weight = torch::randn({kNumOut, kSize * 3}) * 0.3f;
+    const auto fc_bias = torch::randn({kNumOut});
+    save_tensor(dir / "fc.weight.tensor", fc_weight);
+    save_tensor(dir / "fc.bias.tensor", fc_bias);
+
+    auto model = dorado::load_remora_model(
+            dir, torch::TensorOptions().device(torch::kCPU).dtype(torch::kFloat32));
+
+    const int batch_size = 5;
+    const auto sigs = torch::randn({batch_size, 1, kContextSamples});
+    // One-hot kmers, (batch, signal, kmer_len * 4), with some positions past the end of the read.
+    auto bases = torch::randint(0, 5, {batch_size, kContextSamples, kKmerLen});
+    const auto seqs = torch::one_hot(bases, 5)
+                              .index({"...", torch::indexing::Slice(0, 4)})
+                              .reshape({batch_size, kContextSamples, kKmerLen * 4})
+                              .to(torch::kInt8);
+
+    const auto output = model->forward(sigs, seqs);
+
+    const auto conv = [&](torch::Tensor x, size_t layer) {
+        const auto& [weight, bias] = conv_weights[layer];
+        return torch::silu(torch::conv1d(x, weight, bias, std::get<2>(kConvLayers[layer])));
+    };
+    auto sig_out = conv(conv(conv(sigs, 0), 1), 2);
+    auto seq_out = conv(conv(conv(seqs.permute({0, 2, 1}).to(torch::kFloat32), 3), 4), 5);
+    auto z = torch::cat({sig_out, seq_out}, 1);
+    z = conv(conv(conv(conv(z, 6), 7), 8), 9);
+    const auto expected = torch::linear(z.flatten(1), fc_weight, fc_bias).softmax(1);
+
+    REQUIRE(output.sizes() == expected.sizes());
+    CHECK(torch::allclose(output, expected, 1e-4, 1e-5));
+
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,74 @@
+#include "modbase/remora_scaler.h"
+#include "utils/sequence_utils.h"
+
+#include <catch2/catch.hpp>
+#include <torch/torch.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#define TEST_GROUP "[remora_scaler]"
+
+TEST_CASE("Rescale signal to expected kmer levels", TEST_GROUP) {
+    const size_t KMER_LEN = 3;
+    const size_t CENTRE_INDEX = 1;
+    const size_t BLOCK_STRIDE = 5;
+    const size_t NUM_BASES = 1200;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> level_dist(-2.f, 2.f);
+    std::vector<float> kmer_levels(1 << (2 * KMER_LEN));
+    for (auto& level : kmer_levels) {
+        level = level_dist(gen);
+    }
+
+    std::string sequence;
+    for (size_t i = 0; i < NUM_BASES; ++i) {
+        sequence += "ACGT"[gen() % 4];
+    }
+    const auto seq_ints = dorado::utils::sequence_to_ints(sequence);
+    // One block per base.
+    std::vector<uint8_t> moves(NUM_BASES, 1);
+    const auto seq_to_sig_map =
+            dorado::utils::moves_to_map(moves, BLOCK_STRIDE, NUM_BASES * BLOCK_STRIDE);
+
+    // The expected level of each base is that of the kmer it is the centre of.
+    std::vector<float> base_levels(NUM_BASES, 0.f);
+    for (size_t pos = 0; pos + KMER_LEN < NUM_BASES; ++pos) {
+        size_t index = 0;
+        for (size_t i = 0; i < KMER_LEN; ++i) {
+            index = index * 4 + seq_ints[pos + i];
+        }
+        base_levels[pos + CENTRE_INDEX] = kmer_levels[index];
+    }
+
+    // A signal which is a linear transform of the levels is mapped back onto them.
+    auto signal = torch::empty({int64_t(NUM_BASES * BLOCK_STRIDE)}, torch::kFloat32);
+    auto expected = torch::empty_like(signal);
+    for (size_t i = 0; i < NUM_BASES * BLOCK_STRIDE; ++i) {
+        const float level = base_levels[i / BLOCK_STRIDE];
+        signal[i] = 2.f * level + 0.5f;
+        expected[i] = level;
+    }
+    signal = signal.to(torch::kFloat16);
+
+    dorado::RemoraScaler scaler(kmer_levels, KMER_LEN, CENTRE_INDEX);
+
+    SECTION("float32 output") {
+        const auto scaled = scaler.scale_signal(signal, seq_ints, seq_to_sig_map, torch::kFloat32);
+        CHECK(scaled.dtype() == torch::kFloat32);
+        CHECK(scaled.is_contiguous());
+        CHECK(torch::allclose(scaled, expected, 1e-3, 1e-2));
+    }
+
+    SECTION("float16 output") {
+        const auto scaled = scaler.scale_signal(signal, seq_ints, seq_to_sig_map);
+        CHECK(scaled.dtype() == torch::kFloat16);
+        CHECK(torch::allclose(scaled.to(torch::kFloat32), expected, 1e-2, 1e-2));
+    }
+
+    SECTION("Only float outputs are supported") {
+        CHECK_THROWS(scaler.scale_signal(signal, seq_ints, seq_to_sig_map, torch::kInt16));
+    }
+}
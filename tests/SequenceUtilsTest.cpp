@@ -2,7 +2,11 @@
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <limits>
+#include <vector>
 
 #define TEST_GROUP "[utils]"
 
@@ -82,3 +86,29 @@ TEST_CASE(TEST_GROUP "mean_q_score from non-zero start position") {
 
     CHECK_THROWS_AS(dorado::utils::mean_qscore_from_qstring("####", 10), std::runtime_error);
 }
+
+TEST_CASE(TEST_GROUP "qstring_from_error_probs") {
+    CHECK(dorado::utils::qstring_from_error_probs(nullptr, 0, 0.0f, 1.0f).empty());
+
+    // Compare against computing each qscore directly, away from the character boundaries where
+    // rounding could tip either way.
+    const float kShift = -0.3f;
+    const float kScale = 0.95f;
+    std::vector<float> error_probs;
+    std::string expected;
+    for (float qscore = 0.05f; qscore < 60.0f; qscore += 0.1f) {
+        const float calibrated = std::clamp(qscore * kScale + kShift, 1.0f, 50.0f);
+        if (std::abs(calibrated + 0.5f - std::round(calibrated + 0.5f)) < 0.01f) {
+            continue;
+        }
+        error_probs.push_back(std::pow(10.0f, -qscore / 10.0f));
+        expected.push_back(static_cast<char>(33.5f + calibrated));
+    }
+    CHECK(dorado::utils::qstring_from_error_probs(error_probs.data(), error_probs.size(), kShift,
+                                                  kScale) == expected);
+
+    // Certain bases, or undefined probabilities, get the maximum qscore.
+    const std::vector<float> kEdgeCases = {0.0f, std::numeric_limits<float>::quiet_NaN(), 1.0f};
+    CHECK(dorado::utils::qstring_from_error_probs(kEdgeCases.data(), kEdgeCases.size(), 0.0f,
+                                                  1.0f) == "SS\"");
+}
@@ -76,3 +76,70 @@ TEST_CASE("Test stitch_chunks", TEST_GROUP) {
     REQUIRE(read->qstring == expected_qstring);
     REQUIRE(read->moves == expected_moves);
 }
+
+TEST_CASE("Test stitch_chunks with deferred qstrings", TEST_GROUP) {
+    constexpr size_t CHUNK_SIZE = 10;
+    constexpr size_t OVERLAP = 3;
+    // Error probabilities giving the qstring characters of QSTR, other than the first, as Q1 is
+    // the lowest qscore generated.
+    const std::vector<float> ERROR_PROBS{1.0f, 0.316f, 0.05f, 0.063f};
+
+    auto read = std::make_shared<dorado::Read>();
+    read->num_chunks = 0;
+
+    size_t offset = 0;
+    size_t chunk_in_read_idx = 0;
+    size_t signal_chunk_step = CHUNK_SIZE - OVERLAP;
+    while (read->num_chunks == 0 || offset + CHUNK_SIZE < RAW_SIGNAL_SIZE) {
+        if (read->num_chunks != 0) {
+            offset = std::min(offset + signal_chunk_step, RAW_SIGNAL_SIZE - CHUNK_SIZE);
+        }
+        auto chunk =
+                std::make_shared<dorado::Chunk>(read, offset, chunk_in_read_idx++, CHUNK_SIZE);
+        chunk->seq = SEQS[read->num_chunks];
+        chunk->moves = MOVES[read->num_chunks];
+        chunk->base_error_probs = ERROR_PROBS;
+        read->called_chunks.push_back(chunk);
+        read->num_chunks++;
+    }
+
+    REQUIRE_NOTHROW(dorado::utils::stitch_chunks(read));
+
+    REQUIRE(read->seq == "ACGTCGCGTCGTCGTCCGT");
+    REQUIRE(read->qstring == "\"&.-&.&.-&.-&.-&&.-");
+}
+
+TEST_CASE("Test stitch_chunks with a mix of qstrings and deferred qstrings", TEST_GROUP) {
+    constexpr size_t CHUNK_SIZE = 10;
+    constexpr size_t OVERLAP = 3;
+    const std::vector<float> ERROR_PROBS{1.0f, 0.316f, 0.05f, 0.063f};
+
+    // As when some chunks of a read come from the chunk cache and the others are freshly called.
+    auto read = std::make_shared<dorado::Read>();
+    read->num_chunks = 0;
+
+    size_t offset = 0;
+    size_t chunk_in_read_idx = 0;
+    size_t signal_chunk_step = CHUNK_SIZE - OVERLAP;
+    while (read->num_chunks == 0 || offset + CHUNK_SIZE < RAW_SIGNAL_SIZE) {
+        if (read->num_chunks != 0) {
+            offset = std::min(offset + signal_chunk_step, RAW_SIGNAL_SIZE - CHUNK_SIZE);
+        }
+        auto chunk =
+                std::make_shared<dorado::Chunk>(read, offset, chunk_in_read_idx++, CHUNK_SIZE);
+        chunk->seq = SEQS[read->num_chunks];
+        chunk->moves = MOVES[read->num_chunks];
+        if (read->num_chunks % 2 == 0) {
+            chunk->qstring = QSTR[read->num_chunks];
+        } else {
+            chunk->base_error_probs = ERROR_PROBS;
+        }
+        read->called_chunks.push_back(chunk);
+        read->num_chunks++;
+    }
+
+    REQUIRE_NOTHROW(dorado::utils::stitch_chunks(read));
+
+    REQUIRE(read->seq == "ACGTCGCGTCGTCGTCCGT");
+    REQUIRE(read->qstring == "!&.-&.&.-&.-&.-&&.-");
+}
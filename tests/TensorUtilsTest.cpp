@@ -3,8 +3,14 @@
 #include <catch2/catch.hpp>
 #include <torch/torch.h>
 
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <filesystem>
+#include <iterator>
 #include <random>
+#include <string>
+#include <vector>
 
 #define CUT_TAG "[TensorUtils]"
 
@@ -136,3 +142,54 @@ TEST_CASE(CUT_TAG ": copy_tensor_elems", CUT_TAG) {
         }
     }
 }
+
+TEST_CASE(CUT_TAG ": pack_tensors round trip", CUT_TAG) {
+    torch::manual_seed(42);
+
+    const auto dir = std::filesystem::temp_directory_path() / "dorado_pack_tensors_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    const std::vector<std::string> names{"a.weight.tensor", "b.bias.tensor", "c.weight.tensor"};
+    const std::vector<torch::Tensor> tensors{
+            torch::rand({3, 17}, torch::kFloat32),
+            torch::rand({5}, torch::kFloat16),
+            torch::randint(-128, 127, {2, 3, 4}, torch::kInt8),
+    };
+    for (size_t i = 0; i < names.size(); ++i) {
+        torch::save(std::vector<torch::Tensor>{tensors[i]}, (dir / names[i]).string());
+    }
+
+    const auto unpacked = dorado::utils::load_tensors(dir, names);
+    REQUIRE(dorado::utils::pack_tensors(dir) == names.size());
+
+    // Request a different order and subset to the one in the file.
+    const auto packed = dorado::utils::load_tensors(dir, {names[2], names[0]});
+    REQUIRE(packed.size() == 2);
+    CHECK(torch::equal(packed[0], unpacked[2]));
+    CHECK(torch::equal(packed[1], unpacked[0]));
+    for (const auto& tensor : packed) {
+        CHECK(reinterpret_cast<uintptr_t>(tensor.data_ptr()) % 64 == 0);
+    }
+
+    CHECK_THROWS(dorado::utils::load_tensors(dir, {"missing.tensor"}));
+    // Only the packed file is left alongside the .tensor files.
+    const auto num_files = size_t(std::distance(std::filesystem::directory_iterator(dir),
+                                                std::filesystem::directory_iterator()));
+    CHECK(num_files == names.size() + 1);
+
+    // Once a .tensor file changes, the packed file is out of date and is no longer used.
+    const auto updated = torch::rand({3, 17}, torch::kFloat32);
+    torch::save(std::vector<torch::Tensor>{updated}, (dir / names[0]).string());
+    std::filesystem::last_write_time(
+            dir / names[0],
+            std::filesystem::last_write_time(dir / names[0]) + std::chrono::seconds(1));
+    CHECK(torch::equal(dorado::utils::load_tensors(dir, {names[0]})[0], updated));
+
+    // As is a packed file missing a .tensor file added since.
+    REQUIRE(dorado::utils::pack_tensors(dir) == names.size());
+    torch::save(std::vector<torch::Tensor>{updated}, (dir / "d.weight.tensor").string());
+    CHECK(torch::equal(dorado::utils::load_tensors(dir, {"d.weight.tensor"})[0], updated));
+
+    std::filesystem::remove_all(dir);
+}
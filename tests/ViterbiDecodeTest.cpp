@@ -0,0 +1,183 @@
+#include "decode/beam_search.h"
+#include "decode/crf_scan.h"
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <torch/torch.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#define CUT_TAG "[ViterbiDecode]"
+
+namespace {
+
+// Random scores for a chunk, with a single path through the states made much more likely than
+// any other.
+torch::Tensor make_scores(int num_blocks, int num_states, float path_boost) {
+    auto scores = torch::randn({num_blocks, num_states * 4}) * 1.5f;
+    auto scores_a = scores.accessor<float, 2>();
+    int state = 0;
+    for (int block = 0; block < num_blocks; ++block) {
+        // Stay on every third block.
+        if (block % 3 == 2) {
+            continue;
+        }
+        const int new_state = (state * 4) % num_states + (block * 7) % 4;
+        scores_a[block][new_state * 4 + state / (num_states / 4)] += path_boost;
+        state = new_state;
+    }
+    return scores;
+}
+
+constexpr double kNoPath = -std::numeric_limits<double>::infinity();
+
+// Score of the best path through the CRF, by a plain max-plus pass over every state.  Steps into
+// `state` come from the states which differ only in their oldest base, with the score at
+// `state * 4 + oldest_base`, and stays have the fixed score.
+double best_path_score(const torch::Tensor& scores, float stay) {
+    const auto scores_a = scores.accessor<float, 2>();
+    const int num_states = int(scores.size(1)) / 4;
+    std::vector<double> fwd(num_states, 0.0), next_fwd(num_states);
+    for (int block = 0; block < scores.size(0); ++block) {
+        for (int state = 0; state < num_states; ++state) {
+            next_fwd[state] = fwd[state] + stay;
+            for (int msb = 0; msb < 4; ++msb) {
+                const int prev_state = state / 4 + msb * (num_states / 4);
+                next_fwd[state] = std::max(next_fwd[state],
+                                           fwd[prev_state] + scores_a[block][state * 4 + msb]);
+            }
+        }
+        std::swap(fwd, next_fwd);
+    }
+    return *std::max_element(fwd.begin(), fwd.end());
+}
+
+// Score of the best path through the CRF which a decoder could have reported as `seq` and
+// `moves`: each block that moves emits its state's newest base.  The first block is always
+// reported as a move, so may really have been a stay.  kNoPath if there is no such path.
+double called_path_score(const torch::Tensor& scores,
+                         float stay,
+                         const std::string& seq,
+                         const std::vector<uint8_t>& moves) {
+    const auto scores_a = scores.accessor<float, 2>();
+    const int num_states = int(scores.size(1)) / 4;
+    const auto base_index = [](char base) { return int(std::string("ACGT").find(base)); };
+
+    std::vector<double> fwd(num_states, 0.0), next_fwd(num_states);
+    size_t seq_pos = 0;
+    for (int block = 0; block < scores.size(0); ++block) {
+        const bool move = block == 0 || moves[block];
+        if (move && seq_pos == seq.size()) {
+            return kNoPath;
+        }
+        const int base = move ? base_index(seq[seq_pos++]) : -1;
+        for (int state = 0; state < num_states; ++state) {
+            next_fwd[state] = kNoPath;
+            if (!move || block == 0) {
+                next_fwd[state] = fwd[state] + stay;
+            }
+            if (move) {
+                for (int msb = 0; msb < 4; ++msb) {
+                    const int prev_state = state / 4 + msb * (num_states / 4);
+                    next_fwd[state] = std::max(next_fwd[state],
+                                               fwd[prev_state] + scores_a[block][state * 4 + msb]);
+                }
+                if (state % 4 != base) {
+                    next_fwd[state] = kNoPath;
+                }
+            }
+        }
+        std::swap(fwd, next_fwd);
+    }
+    return seq_pos == seq.size() ? *std::max_element(fwd.begin(), fwd.end()) : kNoPath;
+}
+
+std::tuple<std::string, std::string, std::vector<uint8_t>> beam_decode(const torch::Tensor& scores,
+                                                                       float stay,
+                                                                       size_t beam_width) {
+    const int num_blocks = int(scores.size(0));
+    const int num_states = int(scores.size(1)) / 4;
+    dorado::CRFScan scan(num_states);
+    scan.run(scores.data_ptr<float>(), num_blocks, scores.stride(0), stay);
+    const auto bwd = torch::from_blob(const_cast<float*>(scan.back_guides()),
+                                      {num_blocks + 1, num_states});
+    const auto posts =
+            torch::from_blob(const_cast<float*>(scan.posts()), {num_blocks + 1, num_states});
+    return beam_search_decode(scores, bwd, posts, beam_width, 100.0f, stay, 0.0f, 1.0f, 1.0f,
+                              1.0f);
+}
+
+}  // namespace
+
+TEST_CASE(CUT_TAG ": matches beam search on a clear path", CUT_TAG) {
+    torch::manual_seed(42);
+
+    const int num_blocks = 300;
+    const int num_states = 64;
+    const float stay = 2.0f;
+    const auto scores = make_scores(num_blocks, num_states, 8.0f);
+
+    const auto [beam_seq, beam_qstring, beam_moves] = beam_decode(scores, stay, 32);
+
+    const auto [seq, qstring, moves] = viterbi_decode(scores, stay, 0.0f, 1.0f, 1.0f);
+
+    CHECK(seq == beam_seq);
+    CHECK(qstring.size() == seq.size());
+    CHECK(size_t(std::accumulate(moves.begin(), moves.end(), 0)) == seq.size());
+}
+
+TEST_CASE(CUT_TAG ": finds the best path on random scores", CUT_TAG) {
+    torch::manual_seed(42);
+
+    const int num_blocks = 200;
+    const int num_states = 64;
+    const float stay = 2.0f;
+    for (int trial = 0; trial < 5; ++trial) {
+        CAPTURE(trial);
+        // No path stands out, so the decoders' choices differ.
+        const auto scores = torch::randn({num_blocks, num_states * 4}) * 2.0f;
+        const double best_score = best_path_score(scores, stay);
+        // Sums of 200 scores, accumulated in float by the decoder.
+        const auto score_margin = Approx(best_score).margin(1e-3 * num_blocks);
+
+        const auto [seq, qstring, moves] = viterbi_decode(scores, stay, 0.0f, 1.0f, 1.0f);
+        CHECK(called_path_score(scores, stay, seq, moves) == score_margin);
+
+        // Beam search maximises total rather than single path probability, so it can only do as
+        // well as the Viterbi path, however wide the beam.
+        for (size_t beam_width : {1, 32}) {
+            CAPTURE(beam_width);
+            const auto [beam_seq, beam_qstring, beam_moves] =
+                    beam_decode(scores, stay, beam_width);
+            const double beam_score = called_path_score(scores, stay, beam_seq, beam_moves);
+            CHECK(beam_score != kNoPath);
+            CHECK(beam_score <= best_score + 1e-3 * num_blocks);
+        }
+    }
+}
+
+// Hidden from the default run.  Run with `dorado_tests [benchmark]`, or build the
+// decode_benchmark target.
+TEST_CASE(CUT_TAG ": benchmark against beam search", "[.][benchmark]") {
+    torch::manual_seed(42);
+
+    // A typical chunk: 5-mer states, and 10000 samples at stride 5.
+    const int num_blocks = 2000;
+    const int num_states = 1024;
+    const float stay = 2.0f;
+    const auto scores = make_scores(num_blocks, num_states, 4.0f);
+
+    BENCHMARK("viterbi") { return viterbi_decode(scores, stay, 0.0f, 1.0f, 1.0f); };
+    BENCHMARK("beam search, width 1") { return beam_decode(scores, stay, 1); };
+    BENCHMARK("beam search, width 32") { return beam_decode(scores, stay, 32); };
+}
+
+TEST_CASE(CUT_TAG ": rejects non-float scores", CUT_TAG) {
+    const auto scores = torch::zeros({10, 64 * 4}, torch::kInt8);
+    CHECK_THROWS_AS(viterbi_decode(scores, 2.0f, 0.0f, 1.0f, 1.0f), std::runtime_error);
+}
@@ -1,4 +1,6 @@
 #define CATCH_CONFIG_RUNNER
+// Benchmark support must be compiled into the runner as well as the files with benchmarks.
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include <catch2/catch.hpp>
 #include <torch/torch.h>
 